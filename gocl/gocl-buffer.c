@@ -42,6 +42,17 @@
  * Both gocl_buffer_write_sync() and gocl_buffer_read_sync() block program
  * execution, while gocl_buffer_write() and gocl_buffer_read() are asynchronous
  * versions and safe to call from the application's main loop.
+ *
+ * When issuing many small transfers, gocl_buffer_read_v() and
+ * gocl_buffer_write_v() take the event wait list as a plain array, and
+ * avoid allocating memory on every call. For transfers that are never waited
+ * for individually, gocl_buffer_read_detached() and
+ * gocl_buffer_write_detached() do not create any #GoclEvent at all.
+ *
+ * For code built around #GCancellable and #GAsyncResult, the
+ * gocl_buffer_read_async() and gocl_buffer_write_async() variants follow the
+ * standard GIO asynchronous pattern, and allow cancelling a transfer that is
+ * still waiting on its event list.
  **/
 
 /**
@@ -74,6 +85,22 @@ struct _GoclBufferPrivate
   gpointer host_ptr;
 };
 
+typedef struct
+{
+  cl_mem buffer;
+  gboolean write;
+  gpointer ptr;
+  gsize size;
+  goffset offset;
+} Transfer;
+
+typedef struct
+{
+  GoclBuffer *self;
+  gpointer target_ptr;
+  gsize *size;
+} ReadAll;
+
 /* properties */
 enum
 {
@@ -334,6 +361,244 @@ read_all (GoclBuffer          *self,
                               out_event);
 }
 
+static cl_int
+enqueue_transfer (cl_command_queue  queue,
+                  guint             event_wait_list_len,
+                  const cl_event   *event_wait_list,
+                  cl_event         *out_event,
+                  gpointer          user_data)
+{
+  Transfer *transfer = user_data;
+
+  if (transfer->write)
+    return clEnqueueWriteBuffer (queue,
+                                 transfer->buffer,
+                                 CL_FALSE,
+                                 transfer->offset,
+                                 transfer->size,
+                                 transfer->ptr,
+                                 event_wait_list_len,
+                                 event_wait_list,
+                                 out_event);
+  else
+    return clEnqueueReadBuffer (queue,
+                                transfer->buffer,
+                                CL_FALSE,
+                                transfer->offset,
+                                transfer->size,
+                                transfer->ptr,
+                                event_wait_list_len,
+                                event_wait_list,
+                                out_event);
+}
+
+static cl_int
+enqueue_read_all (cl_command_queue  queue,
+                  guint             event_wait_list_len,
+                  const cl_event   *event_wait_list,
+                  cl_event         *out_event,
+                  gpointer          user_data)
+{
+  ReadAll *read_all = user_data;
+  GoclBufferClass *class;
+
+  class = GOCL_BUFFER_GET_CLASS (read_all->self);
+  g_assert (class->read_all != NULL);
+
+  return class->read_all (read_all->self,
+                          read_all->self->priv->buf,
+                          queue,
+                          read_all->target_ptr,
+                          read_all->size,
+                          FALSE,
+                          (cl_event *) event_wait_list,
+                          event_wait_list_len,
+                          out_event);
+}
+
+static cl_int
+transfer_enqueue (GoclBuffer      *self,
+                  gboolean         write,
+                  GoclQueue       *queue,
+                  gpointer         ptr,
+                  gsize            size,
+                  goffset          offset,
+                  guint            event_wait_list_len,
+                  const cl_event  *event_wait_list,
+                  cl_event        *out_event)
+{
+  Transfer transfer;
+  GoclBufferAccess access;
+
+  transfer.buffer = self->priv->buf;
+  transfer.write = write;
+  transfer.ptr = ptr;
+  transfer.size = size;
+  transfer.offset = offset;
+
+  access.buffer = self;
+  access.write = write;
+  access.transfer_size = size;
+
+  return gocl_queue_enqueue (queue,
+                             &access,
+                             1,
+                             event_wait_list_len,
+                             event_wait_list,
+                             out_event,
+                             enqueue_transfer,
+                             &transfer);
+}
+
+static gboolean
+transfer_sync (GoclBuffer  *self,
+               gboolean     write,
+               GoclQueue   *queue,
+               gpointer     ptr,
+               gsize        size,
+               goffset      offset,
+               GList       *event_wait_list)
+{
+  cl_event *_event_wait_list;
+  cl_event event;
+  cl_int err_code;
+
+  _event_wait_list = gocl_event_list_to_array (event_wait_list, NULL);
+
+  /* the command is enqueued non-blocking and waited for afterwards, so that
+     hazard tracking never blocks other threads enqueuing in the same queue */
+  err_code = transfer_enqueue (self,
+                               write,
+                               queue,
+                               ptr,
+                               size,
+                               offset,
+                               g_list_length (event_wait_list),
+                               _event_wait_list,
+                               &event);
+  g_free (_event_wait_list);
+
+  if (gocl_error_check_opencl_internal (err_code))
+    return FALSE;
+
+  err_code = clWaitForEvents (1, &event);
+  clReleaseEvent (event);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
+static void
+transfer_async (GoclBuffer          *self,
+                gboolean             write,
+                GoclQueue           *queue,
+                gpointer             ptr,
+                gsize                size,
+                goffset              offset,
+                GList               *event_wait_list,
+                GCancellable        *cancellable,
+                GAsyncReadyCallback  callback,
+                gpointer             user_data,
+                gpointer             source_tag)
+{
+  GTask *task;
+  Transfer transfer;
+  GoclBufferAccess access;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, source_tag);
+
+  transfer.buffer = self->priv->buf;
+  transfer.write = write;
+  transfer.ptr = ptr;
+  transfer.size = size;
+  transfer.offset = offset;
+
+  access.buffer = self;
+  access.write = write;
+  access.transfer_size = size;
+
+  gocl_event_enqueue_task (task,
+                           queue,
+                           event_wait_list,
+                           &access,
+                           1,
+                           enqueue_transfer,
+                           &transfer);
+}
+
+static GoclEvent *
+transfer_v (GoclBuffer  *self,
+            gboolean     write,
+            GoclQueue   *queue,
+            gpointer     ptr,
+            gsize        size,
+            goffset      offset,
+            GoclEvent  **event_wait_list,
+            guint        event_wait_list_len)
+{
+  cl_event inline_list[GOCL_EVENT_INLINE_WAIT_LIST_SIZE];
+  cl_event *_event_wait_list;
+  cl_event event;
+  cl_int err_code;
+  GoclEvent *_event;
+
+  _event_wait_list = gocl_event_array_to_cl_array (event_wait_list,
+                                                   event_wait_list_len,
+                                                   inline_list);
+
+  err_code = transfer_enqueue (self,
+                               write,
+                               queue,
+                               ptr,
+                               size,
+                               offset,
+                               event_wait_list_len,
+                               _event_wait_list,
+                               &event);
+
+  if (_event_wait_list != inline_list)
+    g_free (_event_wait_list);
+
+  _event = gocl_event_new_from_enqueue (queue, err_code, event);
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
+
+static gboolean
+transfer_detached (GoclBuffer  *self,
+                   gboolean     write,
+                   GoclQueue   *queue,
+                   gpointer     ptr,
+                   gsize        size,
+                   goffset      offset,
+                   GoclEvent  **event_wait_list,
+                   guint        event_wait_list_len)
+{
+  cl_event inline_list[GOCL_EVENT_INLINE_WAIT_LIST_SIZE];
+  cl_event *_event_wait_list;
+  cl_int err_code;
+
+  _event_wait_list = gocl_event_array_to_cl_array (event_wait_list,
+                                                   event_wait_list_len,
+                                                   inline_list);
+
+  err_code = transfer_enqueue (self,
+                               write,
+                               queue,
+                               ptr,
+                               size,
+                               offset,
+                               event_wait_list_len,
+                               _event_wait_list,
+                               NULL);
+
+  if (_event_wait_list != inline_list)
+    g_free (_event_wait_list);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
 /* public */
 
 /**
@@ -403,6 +668,23 @@ gocl_buffer_get_context (GoclBuffer *buffer)
   return buffer->priv->context;
 }
 
+/**
+ * gocl_buffer_get_flags:
+ * @self: The #GoclBuffer
+ *
+ * Retrieves the flags used when creating the buffer. This is the same value
+ * as the #GoclBuffer:flags property.
+ *
+ * Returns: An OR'ed combination of values from #GoclBufferFlags
+ **/
+guint
+gocl_buffer_get_flags (GoclBuffer *self)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), 0);
+
+  return self->priv->flags;
+}
+
 /**
  * gocl_buffer_read:
  * @self: The #GoclBuffer
@@ -441,7 +723,6 @@ gocl_buffer_read (GoclBuffer *self,
   GError *error = NULL;
   cl_int err_code;
   cl_event event;
-  cl_command_queue _queue;
 
   GoclEvent *_event = NULL;
   GoclEventResolverFunc resolver_func;
@@ -453,34 +734,27 @@ gocl_buffer_read (GoclBuffer *self,
 
   _event_wait_list = gocl_event_list_to_array (event_wait_list, NULL);
 
-  _queue = gocl_queue_get_queue (queue);
-
-  err_code = clEnqueueReadBuffer (_queue,
-                                  self->priv->buf,
-                                  CL_FALSE,
-                                  offset,
-                                  size,
-                                  target_ptr,
-                                  g_list_length (event_wait_list),
-                                  _event_wait_list,
-                                  &event);
+  err_code = transfer_enqueue (self,
+                               FALSE,
+                               queue,
+                               target_ptr,
+                               size,
+                               offset,
+                               g_list_length (event_wait_list),
+                               _event_wait_list,
+                               &event);
   g_free (_event_wait_list);
 
   if (gocl_error_check_opencl (err_code, &error))
     {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             NULL);
+      _event = gocl_event_new (queue, NULL);
       resolver_func = gocl_event_steal_resolver_func (_event);
       resolver_func (_event, error);
       g_error_free (error);
     }
   else
     {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             "event", event,
-                             NULL);
+      _event = gocl_event_new (queue, event);
       gocl_event_set_event_wait_list (_event, event_wait_list);
       gocl_event_steal_resolver_func (_event);
     }
@@ -490,6 +764,94 @@ gocl_buffer_read (GoclBuffer *self,
   return _event;
 }
 
+/**
+ * gocl_buffer_read_v:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target_ptr: (array length=size) (element-type guint8): The pointer to copy
+ * the data to
+ * @size: The size of the data to be read
+ * @offset: The offset to start reading from
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array of
+ * #GoclEvent objects to wait for, or %NULL
+ * @event_wait_list_len: The length of @event_wait_list
+ *
+ * Like gocl_buffer_read(), but takes the events to wait for as a
+ * caller-owned array. This avoids allocating memory and walking a list on
+ * every call, for applications issuing many small reads.
+ *
+ * The array is only accessed during the call, and no references to the
+ * events in it are kept.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the read
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_read_v (GoclBuffer  *self,
+                    GoclQueue   *queue,
+                    gpointer     target_ptr,
+                    gsize        size,
+                    goffset      offset,
+                    GoclEvent  **event_wait_list,
+                    guint        event_wait_list_len)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+
+  return transfer_v (self,
+                     FALSE,
+                     queue,
+                     target_ptr,
+                     size,
+                     offset,
+                     event_wait_list,
+                     event_wait_list_len);
+}
+
+/**
+ * gocl_buffer_read_detached:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target_ptr: (array length=size) (element-type guint8): The pointer to copy
+ * the data to
+ * @size: The size of the data to be read
+ * @offset: The offset to start reading from
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array of
+ * #GoclEvent objects to wait for, or %NULL
+ * @event_wait_list_len: The length of @event_wait_list
+ *
+ * Enqueues a non-blocking read like gocl_buffer_read_v(), but without creating
+ * any event to track its completion. This is the cheapest way of enqueuing a
+ * read that is never waited for individually.
+ *
+ * To know when the data is available in @target_ptr, use
+ * gocl_queue_enqueue_marker() on an in-order @queue after the read, or
+ * gocl_queue_finish().
+ *
+ * Returns: %TRUE if the read was enqueued, %FALSE on error
+ **/
+gboolean
+gocl_buffer_read_detached (GoclBuffer  *self,
+                           GoclQueue   *queue,
+                           gpointer     target_ptr,
+                           gsize        size,
+                           goffset      offset,
+                           GoclEvent  **event_wait_list,
+                           guint        event_wait_list_len)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+
+  return transfer_detached (self,
+                            FALSE,
+                            queue,
+                            target_ptr,
+                            size,
+                            offset,
+                            event_wait_list,
+                            event_wait_list_len);
+}
+
 /**
  * gocl_buffer_read_sync:
  * @self: The #GoclBuffer
@@ -517,30 +879,91 @@ gocl_buffer_read_sync (GoclBuffer *self,
                        goffset     offset,
                        GList      *event_wait_list)
 {
-  cl_command_queue _queue;
-  cl_int err_code;
-  cl_event *_event_wait_list = NULL;
-
   g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
   g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
 
-  _event_wait_list = gocl_event_list_to_array (event_wait_list, NULL);
-
-  _queue = gocl_queue_get_queue (queue);
+  return transfer_sync (self,
+                        FALSE,
+                        queue,
+                        target_ptr,
+                        size,
+                        offset,
+                        event_wait_list);
+}
 
-  err_code = clEnqueueReadBuffer (_queue,
-                                  self->priv->buf,
-                                  CL_TRUE,
-                                  offset,
-                                  size,
-                                  target_ptr,
-                                  g_list_length (event_wait_list),
-                                  _event_wait_list,
-                                  NULL);
+/**
+ * gocl_buffer_read_async:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target_ptr: (array length=size) (element-type guint8): The pointer to copy
+ * the data to
+ * @size: The size of the data to be read
+ * @offset: The offset to start reading from
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
+ * @callback: (scope async): A #GAsyncReadyCallback to call when the read
+ * finishes
+ * @user_data: (allow-none): Arbitrary data to pass in @callback, or %NULL
+ *
+ * Asynchronously reads a block of data of @size bytes from remote context
+ * into host memory, starting at @offset, following the GIO asynchronous
+ * pattern. When the operation finishes, @callback is called and
+ * gocl_buffer_read_finish() should be used to get the result.
+ *
+ * The read is enqueued right away, but held back until all the #GoclEvent in
+ * @event_wait_list have triggered. If @cancellable is cancelled during that
+ * time, the read never reaches the device and the operation finishes with
+ * %G_IO_ERROR_CANCELLED. Cancelling after the read was submitted to the device
+ * has no effect.
+ **/
+void
+gocl_buffer_read_async (GoclBuffer          *self,
+                        GoclQueue           *queue,
+                        gpointer             target_ptr,
+                        gsize                size,
+                        goffset              offset,
+                        GList               *event_wait_list,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        gpointer             user_data)
+{
+  g_return_if_fail (GOCL_IS_BUFFER (self));
+  g_return_if_fail (GOCL_IS_QUEUE (queue));
+
+  transfer_async (self,
+                  FALSE,
+                  queue,
+                  target_ptr,
+                  size,
+                  offset,
+                  event_wait_list,
+                  cancellable,
+                  callback,
+                  user_data,
+                  gocl_buffer_read_async);
+}
 
-  g_free (_event_wait_list);
+/**
+ * gocl_buffer_read_finish:
+ * @self: The #GoclBuffer
+ * @result: The #GAsyncResult object passed to the callback
+ * @error: (out) (allow-none): A pointer to a #GError, or %NULL
+ *
+ * Finishes an asynchronous read operation started with
+ * gocl_buffer_read_async().
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_buffer_read_finish (GoclBuffer    *self,
+                         GAsyncResult  *result,
+                         GError       **error)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, self), FALSE);
 
-  return ! gocl_error_check_opencl_internal (err_code);
+  return g_task_propagate_boolean (G_TASK (result), error);
 }
 
 /**
@@ -580,7 +1003,6 @@ gocl_buffer_write (GoclBuffer     *self,
   GError *error = NULL;
   cl_int err_code;
   cl_event event;
-  cl_command_queue _queue;
 
   GoclEvent *_event = NULL;
   GoclEventResolverFunc resolver_func;
@@ -592,34 +1014,27 @@ gocl_buffer_write (GoclBuffer     *self,
 
   _event_wait_list = gocl_event_list_to_array (event_wait_list, NULL);
 
-  _queue = gocl_queue_get_queue (queue);
-
-  err_code = clEnqueueWriteBuffer (_queue,
-                                   self->priv->buf,
-                                   CL_FALSE,
-                                   offset,
-                                   size,
-                                   data,
-                                   g_list_length (event_wait_list),
-                                   _event_wait_list,
-                                   &event);
+  err_code = transfer_enqueue (self,
+                               TRUE,
+                               queue,
+                               data,
+                               size,
+                               offset,
+                               g_list_length (event_wait_list),
+                               _event_wait_list,
+                               &event);
   g_free (_event_wait_list);
 
   if (gocl_error_check_opencl (err_code, &error))
     {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             NULL);
+      _event = gocl_event_new (queue, NULL);
       resolver_func = gocl_event_steal_resolver_func (_event);
       resolver_func (_event, error);
       g_error_free (error);
     }
   else
     {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             "event", event,
-                             NULL);
+      _event = gocl_event_new (queue, event);
       gocl_event_set_event_wait_list (_event, event_wait_list);
       gocl_event_steal_resolver_func (_event);
     }
@@ -629,6 +1044,85 @@ gocl_buffer_write (GoclBuffer     *self,
   return _event;
 }
 
+/**
+ * gocl_buffer_write_v:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @data: A pointer to write data from
+ * @size: The size of the data to be written
+ * @offset: The offset to start writing data to
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array of
+ * #GoclEvent objects to wait for, or %NULL
+ * @event_wait_list_len: The length of @event_wait_list
+ *
+ * Like gocl_buffer_write(), but takes the events to wait for as a
+ * caller-owned array, as described in gocl_buffer_read_v().
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the write
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_write_v (GoclBuffer      *self,
+                     GoclQueue       *queue,
+                     const gpointer   data,
+                     gsize            size,
+                     goffset          offset,
+                     GoclEvent      **event_wait_list,
+                     guint            event_wait_list_len)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+
+  return transfer_v (self,
+                     TRUE,
+                     queue,
+                     data,
+                     size,
+                     offset,
+                     event_wait_list,
+                     event_wait_list_len);
+}
+
+/**
+ * gocl_buffer_write_detached:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @data: A pointer to write data from
+ * @size: The size of the data to be written
+ * @offset: The offset to start writing data to
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array of
+ * #GoclEvent objects to wait for, or %NULL
+ * @event_wait_list_len: The length of @event_wait_list
+ *
+ * Enqueues a non-blocking write like gocl_buffer_write_v(), but without
+ * creating any event to track its completion. The memory referenced by @data
+ * must remain valid until the write completes, which can be determined with
+ * gocl_queue_enqueue_marker() or gocl_queue_finish().
+ *
+ * Returns: %TRUE if the write was enqueued, %FALSE on error
+ **/
+gboolean
+gocl_buffer_write_detached (GoclBuffer      *self,
+                            GoclQueue       *queue,
+                            const gpointer   data,
+                            gsize            size,
+                            goffset          offset,
+                            GoclEvent      **event_wait_list,
+                            guint            event_wait_list_len)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+
+  return transfer_detached (self,
+                            TRUE,
+                            queue,
+                            data,
+                            size,
+                            offset,
+                            event_wait_list,
+                            event_wait_list_len);
+}
+
 /**
  * gocl_buffer_write_sync:
  * @self: The #GoclBuffer
@@ -655,30 +1149,87 @@ gocl_buffer_write_sync (GoclBuffer     *self,
                         goffset         offset,
                         GList          *event_wait_list)
 {
-  cl_command_queue _queue;
-  cl_int err_code;
-  cl_event *_event_wait_list = NULL;
-
   g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
   g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
 
-  _event_wait_list = gocl_event_list_to_array (event_wait_list, NULL);
-
-  _queue = gocl_queue_get_queue (queue);
+  return transfer_sync (self,
+                        TRUE,
+                        queue,
+                        data,
+                        size,
+                        offset,
+                        event_wait_list);
+}
 
-  err_code = clEnqueueWriteBuffer (_queue,
-                                   self->priv->buf,
-                                   CL_TRUE,
-                                   offset,
-                                   size,
-                                   data,
-                                   g_list_length (event_wait_list),
-                                   _event_wait_list,
-                                   NULL);
+/**
+ * gocl_buffer_write_async:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @data: A pointer to write data from
+ * @size: The size of the data to be written
+ * @offset: The offset to start writing data to
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
+ * @callback: (scope async): A #GAsyncReadyCallback to call when the write
+ * finishes
+ * @user_data: (allow-none): Arbitrary data to pass in @callback, or %NULL
+ *
+ * Asynchronously writes a block of data of @size bytes from host memory into
+ * remote context, starting at @offset, following the GIO asynchronous
+ * pattern. When the operation finishes, @callback is called and
+ * gocl_buffer_write_finish() should be used to get the result.
+ *
+ * Cancellation works as described in gocl_buffer_read_async(). The memory
+ * referenced by @data must remain valid until the operation finishes.
+ **/
+void
+gocl_buffer_write_async (GoclBuffer          *self,
+                         GoclQueue           *queue,
+                         const gpointer       data,
+                         gsize                size,
+                         goffset              offset,
+                         GList               *event_wait_list,
+                         GCancellable        *cancellable,
+                         GAsyncReadyCallback  callback,
+                         gpointer             user_data)
+{
+  g_return_if_fail (GOCL_IS_BUFFER (self));
+  g_return_if_fail (GOCL_IS_QUEUE (queue));
+
+  transfer_async (self,
+                  TRUE,
+                  queue,
+                  data,
+                  size,
+                  offset,
+                  event_wait_list,
+                  cancellable,
+                  callback,
+                  user_data,
+                  gocl_buffer_write_async);
+}
 
-  g_free (_event_wait_list);
+/**
+ * gocl_buffer_write_finish:
+ * @self: The #GoclBuffer
+ * @result: The #GAsyncResult object passed to the callback
+ * @error: (out) (allow-none): A pointer to a #GError, or %NULL
+ *
+ * Finishes an asynchronous write operation started with
+ * gocl_buffer_write_async().
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_buffer_write_finish (GoclBuffer    *self,
+                          GAsyncResult  *result,
+                          GError       **error)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, self), FALSE);
 
-  return ! gocl_error_check_opencl_internal (err_code);
+  return g_task_propagate_boolean (G_TASK (result), error);
 }
 
 /**
@@ -757,12 +1308,12 @@ gocl_buffer_read_all_sync (GoclBuffer *self,
                            gsize      *size,
                            GList      *event_wait_list)
 {
-  GoclBufferClass *class;
-  cl_command_queue _queue;
   cl_int err_code;
   cl_event *_event_wait_list = NULL;
   guint event_wait_list_len;
-  cl_mem buffer;
+  cl_event event;
+  ReadAll read_all;
+  GoclBufferAccess access;
 
   g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
   g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
@@ -771,23 +1322,29 @@ gocl_buffer_read_all_sync (GoclBuffer *self,
   _event_wait_list = gocl_event_list_to_array (event_wait_list,
                                                &event_wait_list_len);
 
-  _queue = gocl_queue_get_queue (queue);
-
-  buffer = gocl_buffer_get_buffer (GOCL_BUFFER (self));
+  read_all.self = self;
+  read_all.target_ptr = target_ptr;
+  read_all.size = size;
+
+  access.buffer = self;
+  access.write = FALSE;
+  access.transfer_size = self->priv->size;
+
+  err_code = gocl_queue_enqueue (queue,
+                                 &access,
+                                 1,
+                                 event_wait_list_len,
+                                 _event_wait_list,
+                                 &event,
+                                 enqueue_read_all,
+                                 &read_all);
+  g_free (_event_wait_list);
 
-  class = GOCL_BUFFER_GET_CLASS (self);
-  g_assert (class->read_all != NULL);
+  if (gocl_error_check_opencl_internal (err_code))
+    return FALSE;
 
-  err_code = class->read_all (self,
-                              buffer,
-                              _queue,
-                              target_ptr,
-                              size,
-                              TRUE,
-                              _event_wait_list,
-                              event_wait_list_len,
-                              NULL);
-  g_free (_event_wait_list);
+  err_code = clWaitForEvents (1, &event);
+  clReleaseEvent (event);
 
   return ! gocl_error_check_opencl_internal (err_code);
 }
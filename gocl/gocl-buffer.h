@@ -23,6 +23,7 @@
 #define __GOCL_BUFFER_H__
 
 #include <glib-object.h>
+#include <gio/gio.h>
 #include <CL/opencl.h>
 
 #include "gocl-decls.h"
@@ -73,6 +74,8 @@ struct _GoclBufferClass
 
 GType                  gocl_buffer_get_type                   (void) G_GNUC_CONST;
 
+guint                  gocl_buffer_get_flags                  (GoclBuffer *self);
+
 GoclEvent *            gocl_buffer_read                       (GoclBuffer *self,
                                                                GoclQueue  *queue,
                                                                gpointer    target_ptr,
@@ -85,6 +88,32 @@ gboolean               gocl_buffer_read_sync                  (GoclBuffer  *self
                                                                gsize        size,
                                                                goffset      offset,
                                                                GList       *event_wait_list);
+GoclEvent *            gocl_buffer_read_v                     (GoclBuffer  *self,
+                                                               GoclQueue   *queue,
+                                                               gpointer     target_ptr,
+                                                               gsize        size,
+                                                               goffset      offset,
+                                                               GoclEvent  **event_wait_list,
+                                                               guint        event_wait_list_len);
+gboolean               gocl_buffer_read_detached              (GoclBuffer  *self,
+                                                               GoclQueue   *queue,
+                                                               gpointer     target_ptr,
+                                                               gsize        size,
+                                                               goffset      offset,
+                                                               GoclEvent  **event_wait_list,
+                                                               guint        event_wait_list_len);
+void                   gocl_buffer_read_async                 (GoclBuffer          *self,
+                                                               GoclQueue           *queue,
+                                                               gpointer             target_ptr,
+                                                               gsize                size,
+                                                               goffset              offset,
+                                                               GList               *event_wait_list,
+                                                               GCancellable        *cancellable,
+                                                               GAsyncReadyCallback  callback,
+                                                               gpointer             user_data);
+gboolean               gocl_buffer_read_finish                (GoclBuffer    *self,
+                                                               GAsyncResult  *result,
+                                                               GError       **error);
 GoclEvent *            gocl_buffer_write                      (GoclBuffer     *self,
                                                                GoclQueue      *queue,
                                                                const gpointer  data,
@@ -97,6 +126,32 @@ gboolean               gocl_buffer_write_sync                 (GoclBuffer      *
                                                                gsize            size,
                                                                goffset          offset,
                                                                GList           *event_wait_list);
+GoclEvent *            gocl_buffer_write_v                    (GoclBuffer      *self,
+                                                               GoclQueue       *queue,
+                                                               const gpointer   data,
+                                                               gsize            size,
+                                                               goffset          offset,
+                                                               GoclEvent      **event_wait_list,
+                                                               guint            event_wait_list_len);
+gboolean               gocl_buffer_write_detached             (GoclBuffer      *self,
+                                                               GoclQueue       *queue,
+                                                               const gpointer   data,
+                                                               gsize            size,
+                                                               goffset          offset,
+                                                               GoclEvent      **event_wait_list,
+                                                               guint            event_wait_list_len);
+void                   gocl_buffer_write_async                (GoclBuffer          *self,
+                                                               GoclQueue           *queue,
+                                                               const gpointer       data,
+                                                               gsize                size,
+                                                               goffset              offset,
+                                                               GList               *event_wait_list,
+                                                               GCancellable        *cancellable,
+                                                               GAsyncReadyCallback  callback,
+                                                               gpointer             user_data);
+gboolean               gocl_buffer_write_finish               (GoclBuffer    *self,
+                                                               GAsyncResult  *result,
+                                                               GError       **error);
 
 gboolean               gocl_buffer_read_all_sync              (GoclBuffer  *self,
                                                                GoclQueue   *queue,
@@ -0,0 +1,893 @@
+/*
+ * gocl-command-graph.c
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2014 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+/**
+ * SECTION:gocl-command-graph
+ * @short_description: Object that records a sequence of commands to be
+ * replayed many times
+ * @stability: Unstable
+ *
+ * A #GoclCommandGraph records a sequence of buffer transfers and kernel
+ * executions once, and then enqueues all of them in a #GoclQueue with a
+ * single call to gocl_command_graph_replay(). This is meant for applications
+ * that issue the same work repeatedly, like once per frame.
+ *
+ * Commands are added with gocl_command_graph_add_write(),
+ * gocl_command_graph_add_read() and gocl_command_graph_add_kernel(), which
+ * return the index of the new node in the graph. Each node can depend on
+ * nodes added before it, which is used to order the commands when the queue
+ * executes them out of order. In in-order queues, nodes simply execute in the
+ * order they were added.
+ *
+ * When a kernel is added, its current arguments and work sizes are copied
+ * into the node, using a separate OpenCL kernel object. Later changes to the
+ * #GoclKernel do not affect the graph, and replaying the graph does not need
+ * to set any kernel argument again. Individual values can be patched between
+ * replays with gocl_command_graph_set_kernel_argument(),
+ * gocl_command_graph_set_kernel_argument_buffer(),
+ * gocl_command_graph_set_global_work_size() and
+ * gocl_command_graph_set_host_pointer().
+ *
+ * Replaying creates no #GoclEvent other than the one returned, and allocates
+ * no memory besides the external wait list, if any. A #GoclCommandGraph is
+ * not thread-safe, and should be used from one thread at a time.
+ **/
+
+/**
+ * GoclCommandGraphClass:
+ * @parent_class: The parent class
+ *
+ * The class for #GoclCommandGraph objects.
+ **/
+
+#include "gocl-command-graph.h"
+
+#include "gocl-private.h"
+#include "gocl-decls.h"
+#include "gocl-error.h"
+
+typedef enum
+{
+  NODE_WRITE,
+  NODE_READ,
+  NODE_KERNEL
+} NodeType;
+
+typedef struct
+{
+  NodeType type;
+
+  guint *deps;
+  guint n_deps;
+  cl_event *wait_list;
+
+  /* whether a later node depends on this one */
+  gboolean needs_event;
+  cl_event event;
+
+  /* transfers */
+  GoclBuffer *buffer;
+  gpointer ptr;
+  gsize size;
+  goffset offset;
+
+  /* kernel executions */
+  cl_kernel kernel;
+  guint8 work_dim;
+  gboolean has_offset;
+  gsize global_work_offset[3];
+  gsize global_work_size[3];
+  gsize local_work_size[3];
+  GPtrArray *buffers;
+
+  GoclBufferAccess *accesses;
+  guint n_accesses;
+} Node;
+
+struct _GoclCommandGraphPrivate
+{
+  GoclQueue *queue;
+  gboolean out_of_order;
+
+  GPtrArray *nodes;
+};
+
+/* properties */
+enum
+{
+  PROP_0,
+  PROP_QUEUE
+};
+
+static void           gocl_command_graph_class_init     (GoclCommandGraphClass *class);
+static void           gocl_command_graph_init           (GoclCommandGraph *self);
+static void           gocl_command_graph_dispose        (GObject *obj);
+static void           gocl_command_graph_finalize       (GObject *obj);
+
+static void           set_property                      (GObject      *obj,
+                                                         guint         prop_id,
+                                                         const GValue *value,
+                                                         GParamSpec   *pspec);
+static void           get_property                      (GObject    *obj,
+                                                         guint       prop_id,
+                                                         GValue     *value,
+                                                         GParamSpec *pspec);
+
+static void           free_node                         (gpointer data);
+
+G_DEFINE_TYPE (GoclCommandGraph, gocl_command_graph, G_TYPE_OBJECT);
+
+#define GOCL_COMMAND_GRAPH_GET_PRIVATE(obj)                     \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj),                          \
+                                GOCL_TYPE_COMMAND_GRAPH,        \
+                                GoclCommandGraphPrivate))       \
+
+static void
+gocl_command_graph_class_init (GoclCommandGraphClass *class)
+{
+  GObjectClass *obj_class = G_OBJECT_CLASS (class);
+
+  obj_class->dispose = gocl_command_graph_dispose;
+  obj_class->finalize = gocl_command_graph_finalize;
+  obj_class->get_property = get_property;
+  obj_class->set_property = set_property;
+
+  g_object_class_install_property (obj_class, PROP_QUEUE,
+                                   g_param_spec_object ("queue",
+                                                        "Graph queue",
+                                                        "The queue where the graph is replayed",
+                                                        GOCL_TYPE_QUEUE,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_type_class_add_private (class, sizeof (GoclCommandGraphPrivate));
+}
+
+static void
+gocl_command_graph_init (GoclCommandGraph *self)
+{
+  GoclCommandGraphPrivate *priv;
+
+  self->priv = priv = GOCL_COMMAND_GRAPH_GET_PRIVATE (self);
+
+  priv->queue = NULL;
+  priv->out_of_order = FALSE;
+
+  priv->nodes = g_ptr_array_new_with_free_func (free_node);
+}
+
+static void
+gocl_command_graph_dispose (GObject *obj)
+{
+  GoclCommandGraph *self = GOCL_COMMAND_GRAPH (obj);
+
+  g_ptr_array_set_size (self->priv->nodes, 0);
+
+  if (self->priv->queue != NULL)
+    {
+      g_object_unref (self->priv->queue);
+      self->priv->queue = NULL;
+    }
+
+  G_OBJECT_CLASS (gocl_command_graph_parent_class)->dispose (obj);
+}
+
+static void
+gocl_command_graph_finalize (GObject *obj)
+{
+  GoclCommandGraph *self = GOCL_COMMAND_GRAPH (obj);
+
+  g_ptr_array_unref (self->priv->nodes);
+
+  G_OBJECT_CLASS (gocl_command_graph_parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject      *obj,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+  GoclCommandGraph *self;
+
+  self = GOCL_COMMAND_GRAPH (obj);
+
+  switch (prop_id)
+    {
+    case PROP_QUEUE:
+      self->priv->queue = g_value_dup_object (value);
+      if (self->priv->queue != NULL)
+        self->priv->out_of_order =
+          (gocl_queue_get_flags (self->priv->queue) &
+           GOCL_QUEUE_FLAGS_OUT_OF_ORDER) != 0;
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+get_property (GObject    *obj,
+              guint       prop_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+  GoclCommandGraph *self;
+
+  self = GOCL_COMMAND_GRAPH (obj);
+
+  switch (prop_id)
+    {
+    case PROP_QUEUE:
+      g_value_set_object (value, self->priv->queue);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+unref_buffer (gpointer data)
+{
+  if (data != NULL)
+    g_object_unref (data);
+}
+
+static void
+free_node (gpointer data)
+{
+  Node *node = data;
+
+  g_free (node->deps);
+  g_free (node->wait_list);
+
+  if (node->event != NULL)
+    clReleaseEvent (node->event);
+
+  if (node->buffer != NULL)
+    g_object_unref (node->buffer);
+
+  if (node->kernel != NULL)
+    clReleaseKernel (node->kernel);
+
+  if (node->buffers != NULL)
+    g_ptr_array_unref (node->buffers);
+
+  g_free (node->accesses);
+
+  g_slice_free (Node, node);
+}
+
+/* rebuilds the buffer accesses of a kernel node, after its buffer
+   arguments change */
+static void
+update_kernel_accesses (Node *node)
+{
+  guint i;
+
+  g_free (node->accesses);
+  node->accesses = g_new (GoclBufferAccess, node->buffers->len);
+  node->n_accesses = 0;
+
+  for (i = 0; i < node->buffers->len; i++)
+    {
+      GoclBuffer *buffer;
+      GoclBufferAccess *access;
+
+      buffer = g_ptr_array_index (node->buffers, i);
+      if (buffer == NULL)
+        continue;
+
+      access = &node->accesses[node->n_accesses];
+      access->buffer = buffer;
+      access->write =
+        (gocl_buffer_get_flags (buffer) & GOCL_BUFFER_FLAGS_READ_ONLY) == 0;
+      access->transfer_size = 0;
+
+      node->n_accesses++;
+    }
+}
+
+static Node *
+add_node (GoclCommandGraph *self,
+          NodeType          type,
+          const guint      *deps,
+          guint             n_deps)
+{
+  Node *node;
+  guint i;
+
+  for (i = 0; i < n_deps; i++)
+    g_return_val_if_fail (deps[i] < self->priv->nodes->len, NULL);
+
+  node = g_slice_new0 (Node);
+  node->type = type;
+
+  if (n_deps > 0)
+    {
+      node->deps = g_memdup (deps, sizeof (guint) * n_deps);
+      node->n_deps = n_deps;
+      node->wait_list = g_new (cl_event, n_deps);
+
+      for (i = 0; i < n_deps; i++)
+        {
+          Node *dep = g_ptr_array_index (self->priv->nodes, deps[i]);
+
+          dep->needs_event = TRUE;
+        }
+    }
+
+  return node;
+}
+
+static gint
+add_transfer (GoclCommandGraph *self,
+              NodeType          type,
+              GoclBuffer       *buffer,
+              gpointer          ptr,
+              gsize             size,
+              goffset           offset,
+              const guint      *deps,
+              guint             n_deps)
+{
+  Node *node;
+
+  node = add_node (self, type, deps, n_deps);
+  if (node == NULL)
+    return -1;
+
+  node->buffer = g_object_ref (buffer);
+  node->ptr = ptr;
+  node->size = size;
+  node->offset = offset;
+
+  node->accesses = g_new (GoclBufferAccess, 1);
+  node->accesses[0].buffer = buffer;
+  node->accesses[0].write = type == NODE_WRITE;
+  node->accesses[0].transfer_size = size;
+  node->n_accesses = 1;
+
+  g_ptr_array_add (self->priv->nodes, node);
+
+  return self->priv->nodes->len - 1;
+}
+
+static Node *
+get_node (GoclCommandGraph *self, guint index, NodeType type)
+{
+  Node *node;
+
+  g_return_val_if_fail (index < self->priv->nodes->len, NULL);
+
+  node = g_ptr_array_index (self->priv->nodes, index);
+
+  if (type == NODE_KERNEL)
+    g_return_val_if_fail (node->type == NODE_KERNEL, NULL);
+  else
+    g_return_val_if_fail (node->type != NODE_KERNEL, NULL);
+
+  return node;
+}
+
+static cl_int
+enqueue_node (cl_command_queue  queue,
+              guint             event_wait_list_len,
+              const cl_event   *event_wait_list,
+              cl_event         *out_event,
+              gpointer          user_data)
+{
+  Node *node = user_data;
+
+  switch (node->type)
+    {
+    case NODE_WRITE:
+      return clEnqueueWriteBuffer (queue,
+                                   gocl_buffer_get_buffer (node->buffer),
+                                   CL_FALSE,
+                                   node->offset,
+                                   node->size,
+                                   node->ptr,
+                                   event_wait_list_len,
+                                   event_wait_list,
+                                   out_event);
+
+    case NODE_READ:
+      return clEnqueueReadBuffer (queue,
+                                  gocl_buffer_get_buffer (node->buffer),
+                                  CL_FALSE,
+                                  node->offset,
+                                  node->size,
+                                  node->ptr,
+                                  event_wait_list_len,
+                                  event_wait_list,
+                                  out_event);
+
+    case NODE_KERNEL:
+      return
+        clEnqueueNDRangeKernel (queue,
+                                node->kernel,
+                                node->work_dim,
+                                node->has_offset ?
+                                  node->global_work_offset : NULL,
+                                node->global_work_size[0] == 0 ?
+                                  NULL : node->global_work_size,
+                                node->local_work_size[0] == 0 ?
+                                  NULL : node->local_work_size,
+                                event_wait_list_len,
+                                event_wait_list,
+                                out_event);
+    }
+
+  g_assert_not_reached ();
+
+  return CL_INVALID_OPERATION;
+}
+
+static void
+release_node_events (GoclCommandGraph *self)
+{
+  guint i;
+
+  for (i = 0; i < self->priv->nodes->len; i++)
+    {
+      Node *node = g_ptr_array_index (self->priv->nodes, i);
+
+      if (node->event != NULL)
+        {
+          clReleaseEvent (node->event);
+          node->event = NULL;
+        }
+    }
+}
+
+/* public */
+
+/**
+ * gocl_command_graph_new:
+ * @queue: The #GoclQueue where the graph will be replayed
+ *
+ * Creates a new, empty command graph.
+ *
+ * Returns: (transfer full): A newly created #GoclCommandGraph
+ **/
+GoclCommandGraph *
+gocl_command_graph_new (GoclQueue *queue)
+{
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+
+  return g_object_new (GOCL_TYPE_COMMAND_GRAPH,
+                       "queue", queue,
+                       NULL);
+}
+
+/**
+ * gocl_command_graph_get_queue:
+ * @self: The #GoclCommandGraph
+ *
+ * Retrieves the #GoclQueue where this graph is replayed.
+ *
+ * Returns: (transfer none): A #GoclQueue
+ **/
+GoclQueue *
+gocl_command_graph_get_queue (GoclCommandGraph *self)
+{
+  g_return_val_if_fail (GOCL_IS_COMMAND_GRAPH (self), NULL);
+
+  return self->priv->queue;
+}
+
+/**
+ * gocl_command_graph_get_num_nodes:
+ * @self: The #GoclCommandGraph
+ *
+ * Retrieves the number of commands recorded in this graph.
+ *
+ * Returns: The number of nodes
+ **/
+guint
+gocl_command_graph_get_num_nodes (GoclCommandGraph *self)
+{
+  g_return_val_if_fail (GOCL_IS_COMMAND_GRAPH (self), 0);
+
+  return self->priv->nodes->len;
+}
+
+/**
+ * gocl_command_graph_add_write:
+ * @self: The #GoclCommandGraph
+ * @buffer: The #GoclBuffer to write to
+ * @data: (array length=size) (element-type guint8): The pointer to copy the
+ * data from when the graph is replayed
+ * @size: The size of the data to be written
+ * @offset: The offset to start writing to
+ * @deps: (array length=n_deps) (allow-none): Indexes of the nodes this one
+ * depends on, or %NULL
+ * @n_deps: The length of @deps
+ *
+ * Records a write of @size bytes from @data to @buffer, starting at @offset.
+ * The memory at @data is read every time the graph is replayed, and must stay
+ * valid until the write finishes.
+ *
+ * Returns: The index of the new node, or -1 on error
+ **/
+gint
+gocl_command_graph_add_write (GoclCommandGraph *self,
+                              GoclBuffer       *buffer,
+                              const gpointer    data,
+                              gsize             size,
+                              goffset           offset,
+                              const guint      *deps,
+                              guint             n_deps)
+{
+  g_return_val_if_fail (GOCL_IS_COMMAND_GRAPH (self), -1);
+  g_return_val_if_fail (GOCL_IS_BUFFER (buffer), -1);
+
+  return add_transfer (self, NODE_WRITE, buffer, data, size, offset,
+                       deps, n_deps);
+}
+
+/**
+ * gocl_command_graph_add_read:
+ * @self: The #GoclCommandGraph
+ * @buffer: The #GoclBuffer to read from
+ * @target_ptr: (array length=size) (element-type guint8): The pointer to copy
+ * the data to when the graph is replayed
+ * @size: The size of the data to be read
+ * @offset: The offset to start reading from
+ * @deps: (array length=n_deps) (allow-none): Indexes of the nodes this one
+ * depends on, or %NULL
+ * @n_deps: The length of @deps
+ *
+ * Records a read of @size bytes from @buffer to @target_ptr, starting at
+ * @offset.
+ *
+ * Returns: The index of the new node, or -1 on error
+ **/
+gint
+gocl_command_graph_add_read (GoclCommandGraph *self,
+                             GoclBuffer       *buffer,
+                             gpointer          target_ptr,
+                             gsize             size,
+                             goffset           offset,
+                             const guint      *deps,
+                             guint             n_deps)
+{
+  g_return_val_if_fail (GOCL_IS_COMMAND_GRAPH (self), -1);
+  g_return_val_if_fail (GOCL_IS_BUFFER (buffer), -1);
+
+  return add_transfer (self, NODE_READ, buffer, target_ptr, size, offset,
+                       deps, n_deps);
+}
+
+/**
+ * gocl_command_graph_add_kernel:
+ * @self: The #GoclCommandGraph
+ * @kernel: The #GoclKernel to execute
+ * @deps: (array length=n_deps) (allow-none): Indexes of the nodes this one
+ * depends on, or %NULL
+ * @n_deps: The length of @deps
+ *
+ * Records an execution of @kernel. The arguments and work sizes currently set
+ * in @kernel are copied into the node, so @kernel can be reconfigured and
+ * added again right after this call.
+ *
+ * Returns: The index of the new node, or -1 on error
+ **/
+gint
+gocl_command_graph_add_kernel (GoclCommandGraph *self,
+                               GoclKernel       *kernel,
+                               const guint      *deps,
+                               guint             n_deps)
+{
+  Node *node;
+  cl_kernel _kernel;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_COMMAND_GRAPH (self), -1);
+  g_return_val_if_fail (GOCL_IS_KERNEL (kernel), -1);
+
+  _kernel = gocl_kernel_dup_kernel (kernel);
+  if (_kernel == NULL)
+    return -1;
+
+  node = add_node (self, NODE_KERNEL, deps, n_deps);
+  if (node == NULL)
+    {
+      clReleaseKernel (_kernel);
+      return -1;
+    }
+
+  node->kernel = _kernel;
+  gocl_kernel_get_work_size (kernel,
+                             &node->work_dim,
+                             node->global_work_offset,
+                             node->global_work_size,
+                             node->local_work_size);
+  node->has_offset = node->global_work_offset[0] != 0 ||
+    node->global_work_offset[1] != 0 ||
+    node->global_work_offset[2] != 0;
+
+  node->buffers = g_ptr_array_new_with_free_func (unref_buffer);
+  for (i = 0; i < gocl_kernel_get_num_arguments_set (kernel); i++)
+    {
+      GoclBuffer *buffer;
+
+      buffer = gocl_kernel_get_argument_buffer (kernel, i);
+      g_ptr_array_add (node->buffers,
+                       buffer != NULL ? g_object_ref (buffer) : NULL);
+    }
+  update_kernel_accesses (node);
+
+  g_ptr_array_add (self->priv->nodes, node);
+
+  return self->priv->nodes->len - 1;
+}
+
+/**
+ * gocl_command_graph_set_host_pointer:
+ * @self: The #GoclCommandGraph
+ * @node: The index of a write or read node
+ * @ptr: The new host pointer to copy the data from or to
+ *
+ * Changes the host memory used by a recorded transfer in the next replays.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_command_graph_set_host_pointer (GoclCommandGraph *self,
+                                     guint             node,
+                                     gpointer          ptr)
+{
+  Node *_node;
+
+  g_return_val_if_fail (GOCL_IS_COMMAND_GRAPH (self), FALSE);
+
+  _node = get_node (self, node, NODE_WRITE);
+  if (_node == NULL)
+    return FALSE;
+
+  _node->ptr = ptr;
+
+  return TRUE;
+}
+
+/**
+ * gocl_command_graph_set_kernel_argument:
+ * @self: The #GoclCommandGraph
+ * @node: The index of a kernel node
+ * @index: The index of the argument in the kernel function
+ * @size: The size of @value, in bytes
+ * @value: A pointer to an arbitrary block of memory
+ *
+ * Changes the value of a kernel argument in a recorded kernel execution, like
+ * gocl_kernel_set_argument() does for a #GoclKernel. The value is used by the
+ * next replays.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_command_graph_set_kernel_argument (GoclCommandGraph *self,
+                                        guint             node,
+                                        guint             index,
+                                        gsize             size,
+                                        const gpointer    value)
+{
+  Node *_node;
+  cl_int err_code;
+
+  g_return_val_if_fail (GOCL_IS_COMMAND_GRAPH (self), FALSE);
+
+  _node = get_node (self, node, NODE_KERNEL);
+  if (_node == NULL)
+    return FALSE;
+
+  err_code = clSetKernelArg (_node->kernel, index, size, value);
+  if (gocl_error_check_opencl_internal (err_code))
+    return FALSE;
+
+  if (index < _node->buffers->len &&
+      g_ptr_array_index (_node->buffers, index) != NULL)
+    {
+      g_object_unref (g_ptr_array_index (_node->buffers, index));
+      g_ptr_array_index (_node->buffers, index) = NULL;
+
+      update_kernel_accesses (_node);
+    }
+
+  return TRUE;
+}
+
+/**
+ * gocl_command_graph_set_kernel_argument_buffer:
+ * @self: The #GoclCommandGraph
+ * @node: The index of a kernel node
+ * @index: The index of the argument in the kernel function
+ * @buffer: A #GoclBuffer
+ *
+ * Changes a buffer argument of a recorded kernel execution, like
+ * gocl_kernel_set_argument_buffer() does for a #GoclKernel. The buffer is
+ * used by the next replays.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_command_graph_set_kernel_argument_buffer (GoclCommandGraph *self,
+                                               guint             node,
+                                               guint             index,
+                                               GoclBuffer       *buffer)
+{
+  Node *_node;
+  cl_mem buf;
+  cl_int err_code;
+
+  g_return_val_if_fail (GOCL_IS_COMMAND_GRAPH (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_BUFFER (buffer), FALSE);
+
+  _node = get_node (self, node, NODE_KERNEL);
+  if (_node == NULL)
+    return FALSE;
+
+  buf = gocl_buffer_get_buffer (buffer);
+
+  err_code = clSetKernelArg (_node->kernel, index, sizeof (cl_mem), &buf);
+  if (gocl_error_check_opencl_internal (err_code))
+    return FALSE;
+
+  if (index >= _node->buffers->len)
+    g_ptr_array_set_size (_node->buffers, index + 1);
+
+  unref_buffer (g_ptr_array_index (_node->buffers, index));
+  g_ptr_array_index (_node->buffers, index) = g_object_ref (buffer);
+
+  update_kernel_accesses (_node);
+
+  return TRUE;
+}
+
+/**
+ * gocl_command_graph_set_global_work_size:
+ * @self: The #GoclCommandGraph
+ * @node: The index of a kernel node
+ * @size1: global work size for the first dimension
+ * @size2: global work size for the second dimension
+ * @size3: global work size for the third dimension
+ *
+ * Changes the global work sizes of a recorded kernel execution, like
+ * gocl_kernel_set_global_work_size() does for a #GoclKernel.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_command_graph_set_global_work_size (GoclCommandGraph *self,
+                                         guint             node,
+                                         gsize             size1,
+                                         gsize             size2,
+                                         gsize             size3)
+{
+  Node *_node;
+
+  g_return_val_if_fail (GOCL_IS_COMMAND_GRAPH (self), FALSE);
+
+  _node = get_node (self, node, NODE_KERNEL);
+  if (_node == NULL)
+    return FALSE;
+
+  _node->global_work_size[0] = size1;
+  _node->global_work_size[1] = size2;
+  _node->global_work_size[2] = size3;
+
+  return TRUE;
+}
+
+/**
+ * gocl_command_graph_replay:
+ * @self: The #GoclCommandGraph
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events the graph should wait for, or %NULL
+ *
+ * Enqueues all the commands recorded in this graph, in the order they were
+ * added. Nodes without dependencies wait for the events in
+ * @event_wait_list; the rest wait for the nodes they depend on.
+ *
+ * The returned event comes from a marker enqueued after the commands (see
+ * gocl_queue_enqueue_marker()), and triggers when all the commands previously
+ * enqueued in the queue complete, including the ones of the graph.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the replay
+ * finishes
+ **/
+GoclEvent *
+gocl_command_graph_replay (GoclCommandGraph *self, GList *event_wait_list)
+{
+  GoclCommandGraphPrivate *priv;
+  cl_event *_event_wait_list;
+  guint event_wait_list_len;
+  cl_int err_code = CL_SUCCESS;
+  GoclEvent *event;
+  guint i;
+  guint j;
+
+  g_return_val_if_fail (GOCL_IS_COMMAND_GRAPH (self), NULL);
+
+  priv = self->priv;
+
+  _event_wait_list = gocl_event_list_to_array (event_wait_list,
+                                               &event_wait_list_len);
+
+  for (i = 0; i < priv->nodes->len && err_code == CL_SUCCESS; i++)
+    {
+      Node *node = g_ptr_array_index (priv->nodes, i);
+      const cl_event *wait_list;
+      guint wait_list_len;
+
+      if (node->n_deps == 0)
+        {
+          wait_list = _event_wait_list;
+          wait_list_len = event_wait_list_len;
+        }
+      else if (priv->out_of_order)
+        {
+          for (j = 0; j < node->n_deps; j++)
+            {
+              Node *dep = g_ptr_array_index (priv->nodes, node->deps[j]);
+
+              node->wait_list[j] = dep->event;
+            }
+
+          wait_list = node->wait_list;
+          wait_list_len = node->n_deps;
+        }
+      else
+        {
+          /* in-order queues already run the node after its dependencies */
+          wait_list = NULL;
+          wait_list_len = 0;
+        }
+
+      err_code = gocl_queue_enqueue (priv->queue,
+                                     node->accesses,
+                                     node->n_accesses,
+                                     wait_list_len,
+                                     wait_list,
+                                     node->needs_event && priv->out_of_order ?
+                                       &node->event : NULL,
+                                     enqueue_node,
+                                     node);
+    }
+
+  g_free (_event_wait_list);
+
+  release_node_events (self);
+
+  if (gocl_error_check_opencl_internal (err_code))
+    {
+      event = gocl_event_new_from_enqueue (priv->queue, err_code, NULL);
+      gocl_event_idle_unref (event);
+
+      return event;
+    }
+
+  return gocl_queue_enqueue_marker (priv->queue, NULL);
+}
@@ -0,0 +1,106 @@
+/*
+ * gocl-command-graph.h
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2014 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+#ifndef __GOCL_COMMAND_GRAPH_H__
+#define __GOCL_COMMAND_GRAPH_H__
+
+#include <glib-object.h>
+
+#include "gocl-queue.h"
+#include "gocl-buffer.h"
+#include "gocl-kernel.h"
+#include "gocl-event.h"
+
+G_BEGIN_DECLS
+
+#define GOCL_TYPE_COMMAND_GRAPH              (gocl_command_graph_get_type ())
+#define GOCL_COMMAND_GRAPH(obj)              (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOCL_TYPE_COMMAND_GRAPH, GoclCommandGraph))
+#define GOCL_COMMAND_GRAPH_CLASS(klass)      (G_TYPE_CHECK_CLASS_CAST ((klass), GOCL_TYPE_COMMAND_GRAPH, GoclCommandGraphClass))
+#define GOCL_IS_COMMAND_GRAPH(obj)           (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOCL_TYPE_COMMAND_GRAPH))
+#define GOCL_IS_COMMAND_GRAPH_CLASS(klass)   (G_TYPE_CHECK_CLASS_TYPE ((klass), GOCL_TYPE_COMMAND_GRAPH))
+#define GOCL_COMMAND_GRAPH_GET_CLASS(obj)    (G_TYPE_INSTANCE_GET_CLASS ((obj), GOCL_TYPE_COMMAND_GRAPH, GoclCommandGraphClass))
+
+typedef struct _GoclCommandGraphClass GoclCommandGraphClass;
+typedef struct _GoclCommandGraph GoclCommandGraph;
+typedef struct _GoclCommandGraphPrivate GoclCommandGraphPrivate;
+
+struct _GoclCommandGraph
+{
+  GObject parent_instance;
+
+  GoclCommandGraphPrivate *priv;
+};
+
+struct _GoclCommandGraphClass
+{
+  GObjectClass parent_class;
+};
+
+GType                  gocl_command_graph_get_type                   (void) G_GNUC_CONST;
+
+GoclCommandGraph *     gocl_command_graph_new                        (GoclQueue *queue);
+
+GoclQueue *            gocl_command_graph_get_queue                  (GoclCommandGraph *self);
+guint                  gocl_command_graph_get_num_nodes              (GoclCommandGraph *self);
+
+gint                   gocl_command_graph_add_write                  (GoclCommandGraph *self,
+                                                                      GoclBuffer       *buffer,
+                                                                      const gpointer    data,
+                                                                      gsize             size,
+                                                                      goffset           offset,
+                                                                      const guint      *deps,
+                                                                      guint             n_deps);
+gint                   gocl_command_graph_add_read                   (GoclCommandGraph *self,
+                                                                      GoclBuffer       *buffer,
+                                                                      gpointer          target_ptr,
+                                                                      gsize             size,
+                                                                      goffset           offset,
+                                                                      const guint      *deps,
+                                                                      guint             n_deps);
+gint                   gocl_command_graph_add_kernel                 (GoclCommandGraph *self,
+                                                                      GoclKernel       *kernel,
+                                                                      const guint      *deps,
+                                                                      guint             n_deps);
+
+gboolean               gocl_command_graph_set_host_pointer           (GoclCommandGraph *self,
+                                                                      guint             node,
+                                                                      gpointer          ptr);
+gboolean               gocl_command_graph_set_kernel_argument        (GoclCommandGraph *self,
+                                                                      guint             node,
+                                                                      guint             index,
+                                                                      gsize             size,
+                                                                      const gpointer    value);
+gboolean               gocl_command_graph_set_kernel_argument_buffer (GoclCommandGraph *self,
+                                                                      guint             node,
+                                                                      guint             index,
+                                                                      GoclBuffer       *buffer);
+gboolean               gocl_command_graph_set_global_work_size       (GoclCommandGraph *self,
+                                                                      guint             node,
+                                                                      gsize             size1,
+                                                                      gsize             size2,
+                                                                      gsize             size3);
+
+GoclEvent *            gocl_command_graph_replay                     (GoclCommandGraph *self,
+                                                                      GList            *event_wait_list);
+
+G_END_DECLS
+
+#endif /* __GOCL_COMMAND_GRAPH_H__ */
@@ -72,7 +72,7 @@ struct _GoclContextPrivate
   cl_context context;
   GoclDeviceType device_type;
 
-  cl_device_id devices[MAX_DEVICES];
+  cl_device_id *devices;
   cl_uint num_devices;
 
   gpointer gl_context;
@@ -183,17 +183,30 @@ gocl_context_initable_init (GInitable     *initable,
   /* @TODO: currently using platform 0 only */
   self->priv->platform_id = gocl_platforms[DEFAULT_PLATFORM_INDEX];
 
+  /* setup context properties */
+  props[0] = CL_CONTEXT_PLATFORM;
+  props[1] = (cl_context_properties) self->priv->platform_id;
+
+  /* a context for sub-devices already has its devices */
+  if (self->priv->devices != NULL)
+    {
+      self->priv->context = clCreateContext (props,
+                                             self->priv->num_devices,
+                                             self->priv->devices,
+                                             NULL,
+                                             NULL,
+                                             &err_code);
+      return ! gocl_error_check_opencl (err_code, error);
+    }
+
   /* get devices */
+  self->priv->devices = g_new0 (cl_device_id, MAX_DEVICES);
   err_code = clGetDeviceIDs (self->priv->platform_id,
                              self->priv->device_type,
                              MAX_DEVICES,
                              self->priv->devices,
                              &self->priv->num_devices);
 
-  /* setup context properties */
-  props[0] = CL_CONTEXT_PLATFORM;
-  props[1] = (cl_context_properties) self->priv->platform_id;
-
   /* enable GL sharing, if a GL context and display are provided */
   if (self->priv->gl_context != NULL && self->priv->gl_display != NULL)
     {
@@ -224,6 +237,8 @@ gocl_context_init (GoclContext *self)
   self->priv = priv = GOCL_CONTEXT_GET_PRIVATE (self);
 
   priv->context = NULL;
+  priv->devices = NULL;
+  priv->num_devices = 0;
 }
 
 static void
@@ -234,6 +249,8 @@ gocl_context_finalize (GObject *obj)
   if (self->priv->context != NULL)
     clReleaseContext (self->priv->context);
 
+  g_free (self->priv->devices);
+
   G_OBJECT_CLASS (gocl_context_parent_class)->finalize (obj);
 
   if (self == gocl_context_default_cpu)
@@ -399,6 +416,47 @@ gocl_context_get_default_cpu_sync (void)
   return gocl_context_default_cpu;
 }
 
+/**
+ * gocl_context_new_for_sub_devices: (skip)
+ * @self: The #GoclContext of the parent device
+ * @devices: (array length=num_devices): The sub-devices
+ * @num_devices: The length of @devices
+ *
+ * Creates a new context containing exactly the sub-devices in @devices,
+ * which must have been partitioned from a device of @self. Command queues
+ * can only be created for the devices of a context, so sub-devices need a
+ * context of their own.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: (transfer full): A newly created #GoclContext, or %NULL on error
+ **/
+GoclContext *
+gocl_context_new_for_sub_devices (GoclContext        *self,
+                                  const cl_device_id *devices,
+                                  guint               num_devices)
+{
+  GoclContext *context;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (self), NULL);
+  g_return_val_if_fail (devices != NULL && num_devices > 0, NULL);
+
+  context = g_object_new (GOCL_TYPE_CONTEXT,
+                          "device-type", self->priv->device_type,
+                          NULL);
+  context->priv->devices = g_memdup (devices,
+                                     sizeof (cl_device_id) * num_devices);
+  context->priv->num_devices = num_devices;
+
+  if (! g_initable_init (G_INITABLE (context), NULL, gocl_error_prepare ()))
+    {
+      g_object_unref (context);
+      return NULL;
+    }
+
+  return context;
+}
+
 /**
  * gocl_context_get_context:
  * @self: The #GoclContext
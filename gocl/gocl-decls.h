@@ -113,6 +113,92 @@ typedef enum
   GOCL_IMAGE_TYPE_3D        = CL_MEM_OBJECT_IMAGE3D
 } GoclImageType;
 
+/**
+ * GoclEventDispatch:
+ * @GOCL_EVENT_DISPATCH_MAIN_CONTEXT: The callback is invoked in the
+ *                                    thread-default main context of the
+ *                                    thread that requested the notification.
+ *                                    This is the default.
+ * @GOCL_EVENT_DISPATCH_DIRECT:       The callback is invoked directly on the
+ *                                    thread that observes the completion,
+ *                                    without going through a main loop.
+ * @GOCL_EVENT_DISPATCH_WORKER:       The callback is invoked on a shared pool
+ *                                    of worker threads.
+ **/
+typedef enum
+{
+  GOCL_EVENT_DISPATCH_MAIN_CONTEXT,
+  GOCL_EVENT_DISPATCH_DIRECT,
+  GOCL_EVENT_DISPATCH_WORKER
+} GoclEventDispatch;
+
+/**
+ * GoclQueueSelection:
+ * @GOCL_QUEUE_SELECTION_ROUND_ROBIN: Queues are handed out in turns. This is
+ *                                    the default.
+ * @GOCL_QUEUE_SELECTION_LEAST_LOADED: The queue with the fewest pending
+ *                                     commands is handed out.
+ **/
+typedef enum
+{
+  GOCL_QUEUE_SELECTION_ROUND_ROBIN,
+  GOCL_QUEUE_SELECTION_LEAST_LOADED
+} GoclQueueSelection;
+
+/**
+ * GoclAddressQualifier:
+ * @GOCL_ADDRESS_QUALIFIER_GLOBAL:   The argument points to global memory.
+ * @GOCL_ADDRESS_QUALIFIER_LOCAL:    The argument points to local memory.
+ * @GOCL_ADDRESS_QUALIFIER_CONSTANT: The argument points to constant memory.
+ * @GOCL_ADDRESS_QUALIFIER_PRIVATE:  The argument is passed by value. This is
+ *                                   the case of scalar and vector arguments.
+ **/
+typedef enum
+{
+  GOCL_ADDRESS_QUALIFIER_GLOBAL   = CL_KERNEL_ARG_ADDRESS_GLOBAL,
+  GOCL_ADDRESS_QUALIFIER_LOCAL    = CL_KERNEL_ARG_ADDRESS_LOCAL,
+  GOCL_ADDRESS_QUALIFIER_CONSTANT = CL_KERNEL_ARG_ADDRESS_CONSTANT,
+  GOCL_ADDRESS_QUALIFIER_PRIVATE  = CL_KERNEL_ARG_ADDRESS_PRIVATE
+} GoclAddressQualifier;
+
+/**
+ * GoclSplitPolicy:
+ * @GOCL_SPLIT_POLICY_COMPUTE_UNITS: Each device gets a part proportional to
+ *                                   its number of compute units.
+ * @GOCL_SPLIT_POLICY_THROUGHPUT:    Each device gets a part proportional to
+ *                                   the throughput measured in previous
+ *                                   executions of the kernel on it. Compute
+ *                                   units are used until every device has
+ *                                   been measured.
+ **/
+typedef enum
+{
+  GOCL_SPLIT_POLICY_COMPUTE_UNITS,
+  GOCL_SPLIT_POLICY_THROUGHPUT
+} GoclSplitPolicy;
+
+/**
+ * GoclAffinityDomain:
+ * @GOCL_AFFINITY_DOMAIN_NUMA:     Compute units sharing a NUMA node.
+ * @GOCL_AFFINITY_DOMAIN_L4_CACHE: Compute units sharing a level 4 cache.
+ * @GOCL_AFFINITY_DOMAIN_L3_CACHE: Compute units sharing a level 3 cache.
+ * @GOCL_AFFINITY_DOMAIN_L2_CACHE: Compute units sharing a level 2 cache.
+ * @GOCL_AFFINITY_DOMAIN_L1_CACHE: Compute units sharing a level 1 cache.
+ * @GOCL_AFFINITY_DOMAIN_NEXT_PARTITIONABLE: The first of the domains above,
+ *                                 from NUMA node down to level 1 cache, along
+ *                                 which the device can be partitioned.
+ **/
+typedef enum
+{
+  GOCL_AFFINITY_DOMAIN_NUMA     = CL_DEVICE_AFFINITY_DOMAIN_NUMA,
+  GOCL_AFFINITY_DOMAIN_L4_CACHE = CL_DEVICE_AFFINITY_DOMAIN_L4_CACHE,
+  GOCL_AFFINITY_DOMAIN_L3_CACHE = CL_DEVICE_AFFINITY_DOMAIN_L3_CACHE,
+  GOCL_AFFINITY_DOMAIN_L2_CACHE = CL_DEVICE_AFFINITY_DOMAIN_L2_CACHE,
+  GOCL_AFFINITY_DOMAIN_L1_CACHE = CL_DEVICE_AFFINITY_DOMAIN_L1_CACHE,
+  GOCL_AFFINITY_DOMAIN_NEXT_PARTITIONABLE =
+    CL_DEVICE_AFFINITY_DOMAIN_NEXT_PARTITIONABLE
+} GoclAffinityDomain;
+
 G_END_DECLS
 
 #endif /* __GOCL_DECLS_H__ */
@@ -35,6 +35,22 @@
  * To enqueue operations on this device, a #GoclQueue provides a default command queue
  * which is obtained by calling gocl_device_get_default_queue(). More device queues can
  * be created by passing this object as 'device' property in the #GoclQueue constructor.
+ *
+ * Independent streams of commands can also be spread over a pool of command
+ * queues owned by the device, to avoid serializing all of them onto the default
+ * queue. The pool is configured with gocl_device_set_queue_pool(), and each call
+ * to gocl_device_get_queue() hands out one of its queues, following a
+ * #GoclQueueSelection policy.
+ *
+ * A device can be partitioned into sub-devices, each one a #GoclDevice on its
+ * own with its own queues, that runs commands only on a subset of the compute
+ * units of the parent device. The sub-devices of a partition share a new
+ * context of their own. gocl_device_partition_equally() and
+ * gocl_device_partition_by_counts() choose the number of compute units of
+ * each sub-device, while gocl_device_partition_by_affinity() groups them by
+ * the NUMA node or cache they share. This is useful to reserve some cores of
+ * a CPU device for latency sensitive work, or to keep the data of a kernel in
+ * the memory close to the cores that run it.
  **/
 
 /**
@@ -58,10 +74,19 @@ struct _GoclDevicePrivate
   GoclContext *context;
   cl_device_id device_id;
 
+  GoclDevice *parent;
+  gboolean is_sub_device;
+
   gsize max_work_group_size;
 
   GoclQueue *queue;
 
+  GMutex queue_pool_mutex;
+  GPtrArray *queue_pool;
+  guint queue_pool_size;
+  GoclQueueSelection queue_selection;
+  guint next_queue;
+
   gchar *extensions;
 };
 
@@ -129,9 +154,18 @@ gocl_device_init (GoclDevice *self)
 
   self->priv = priv = GOCL_DEVICE_GET_PRIVATE (self);
 
+  priv->parent = NULL;
+  priv->is_sub_device = FALSE;
+
   priv->max_work_group_size = 0;
   priv->queue = NULL;
 
+  g_mutex_init (&priv->queue_pool_mutex);
+  priv->queue_pool = NULL;
+  priv->queue_pool_size = 1;
+  priv->queue_selection = GOCL_QUEUE_SELECTION_ROUND_ROBIN;
+  priv->next_queue = 0;
+
   priv->extensions = NULL;
 }
 
@@ -146,12 +180,24 @@ gocl_device_dispose (GObject *obj)
       self->priv->context = NULL;
     }
 
+  if (self->priv->queue_pool != NULL)
+    {
+      g_ptr_array_unref (self->priv->queue_pool);
+      self->priv->queue_pool = NULL;
+    }
+
   if (self->priv->queue != NULL)
     {
       g_object_unref (self->priv->queue);
       self->priv->queue = NULL;
     }
 
+  if (self->priv->parent != NULL)
+    {
+      g_object_unref (self->priv->parent);
+      self->priv->parent = NULL;
+    }
+
   G_OBJECT_CLASS (gocl_device_parent_class)->dispose (obj);
 }
 
@@ -162,6 +208,12 @@ gocl_device_finalize (GObject *obj)
 
   g_free (self->priv->extensions);
 
+  /* sub-devices are reference counted, unlike devices of a platform */
+  if (self->priv->is_sub_device)
+    clReleaseDevice (self->priv->device_id);
+
+  g_mutex_clear (&self->priv->queue_pool_mutex);
+
   G_OBJECT_CLASS (gocl_device_parent_class)->finalize (obj);
 }
 
@@ -217,6 +269,121 @@ get_property (GObject    *obj,
     }
 }
 
+static GoclQueue *
+add_pool_queue (GoclDevice *self)
+{
+  GoclQueue *queue;
+  GError **error;
+
+  error = gocl_error_prepare ();
+  queue = g_initable_new (GOCL_TYPE_QUEUE,
+                          NULL,
+                          error,
+                          "device", self,
+                          NULL);
+  if (queue != NULL)
+    g_ptr_array_add (self->priv->queue_pool, queue);
+
+  return queue;
+}
+
+static GoclQueue *
+select_least_loaded_queue (GoclDevice *self)
+{
+  GoclQueue *queue = NULL;
+  guint min_pending = G_MAXUINT;
+  guint i;
+
+  for (i = 0; i < self->priv->queue_pool->len; i++)
+    {
+      GoclQueue *candidate = g_ptr_array_index (self->priv->queue_pool, i);
+      guint pending = gocl_queue_get_pending_commands (candidate);
+
+      if (pending < min_pending)
+        {
+          queue = candidate;
+          min_pending = pending;
+        }
+    }
+
+  /* only grow the pool when all the existing queues are busy */
+  if (min_pending > 0 &&
+      self->priv->queue_pool->len < self->priv->queue_pool_size)
+    {
+      GoclQueue *new_queue = add_pool_queue (self);
+
+      if (new_queue != NULL)
+        queue = new_queue;
+    }
+
+  return queue;
+}
+
+static GList *
+create_sub_devices (GoclDevice                         *self,
+                    const cl_device_partition_property *properties)
+{
+  cl_device_id *sub_device_ids;
+  cl_uint num_sub_devices;
+  cl_int err_code;
+  GoclContext *context;
+  GList *list = NULL;
+  gint i;
+
+  err_code = clCreateSubDevices (self->priv->device_id,
+                                 properties,
+                                 0,
+                                 NULL,
+                                 &num_sub_devices);
+  if (gocl_error_check_opencl_internal (err_code))
+    return NULL;
+
+  sub_device_ids = g_new (cl_device_id, num_sub_devices);
+
+  err_code = clCreateSubDevices (self->priv->device_id,
+                                 properties,
+                                 num_sub_devices,
+                                 sub_device_ids,
+                                 NULL);
+  if (gocl_error_check_opencl_internal (err_code))
+    {
+      g_free (sub_device_ids);
+      return NULL;
+    }
+
+  /* queues can only be created for devices of their context, and the
+     context of @self does not include the new sub-devices */
+  context = gocl_context_new_for_sub_devices (self->priv->context,
+                                              sub_device_ids,
+                                              num_sub_devices);
+  if (context == NULL)
+    {
+      for (i = 0; i < (gint) num_sub_devices; i++)
+        clReleaseDevice (sub_device_ids[i]);
+      g_free (sub_device_ids);
+      return NULL;
+    }
+
+  for (i = num_sub_devices - 1; i >= 0; i--)
+    {
+      GoclDevice *sub_device;
+
+      sub_device = g_object_new (GOCL_TYPE_DEVICE,
+                                 "context", context,
+                                 "id", sub_device_ids[i],
+                                 NULL);
+      sub_device->priv->parent = g_object_ref (self);
+      sub_device->priv->is_sub_device = TRUE;
+
+      list = g_list_prepend (list, sub_device);
+    }
+
+  g_object_unref (context);
+  g_free (sub_device_ids);
+
+  return list;
+}
+
 static gboolean
 acquire_or_release_gl_objects (GoclDevice  *self,
                                gboolean     acquire,
@@ -372,6 +539,93 @@ gocl_device_get_default_queue (GoclDevice *self)
   return self->priv->queue;
 }
 
+/**
+ * gocl_device_set_queue_pool:
+ * @self: The #GoclDevice
+ * @size: The maximum number of queues in the pool, at least 1
+ * @selection: A value from #GoclQueueSelection
+ *
+ * Configures the pool of command queues handed out by gocl_device_get_queue().
+ * The pool always includes the default queue of the device, and the rest of
+ * the queues are created lazily, as they are needed. By default, the pool
+ * contains only the default queue.
+ *
+ * Reducing @size releases the exceeding queues from the pool, although
+ * they remain alive while other objects hold references to them.
+ **/
+void
+gocl_device_set_queue_pool (GoclDevice         *self,
+                            guint               size,
+                            GoclQueueSelection  selection)
+{
+  g_return_if_fail (GOCL_IS_DEVICE (self));
+  g_return_if_fail (size > 0);
+
+  g_mutex_lock (&self->priv->queue_pool_mutex);
+
+  self->priv->queue_pool_size = size;
+  self->priv->queue_selection = selection;
+
+  if (self->priv->queue_pool != NULL && self->priv->queue_pool->len > size)
+    g_ptr_array_set_size (self->priv->queue_pool, size);
+
+  self->priv->next_queue = 0;
+
+  g_mutex_unlock (&self->priv->queue_pool_mutex);
+}
+
+/**
+ * gocl_device_get_queue:
+ * @self: The #GoclDevice
+ *
+ * Hands out a command queue from the pool of this device, according to the
+ * policy set with gocl_device_set_queue_pool(). Commands enqueued in
+ * different queues may execute concurrently, so independent streams of
+ * commands should each take their own queue and stick to it.
+ *
+ * Returns: (transfer none): A #GoclQueue object, which is owned by the device
+ *   and should not be freed, or %NULL upon error
+ **/
+GoclQueue *
+gocl_device_get_queue (GoclDevice *self)
+{
+  GoclQueue *queue;
+
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), NULL);
+
+  queue = gocl_device_get_default_queue (self);
+  if (queue == NULL)
+    return NULL;
+
+  g_mutex_lock (&self->priv->queue_pool_mutex);
+
+  if (self->priv->queue_pool == NULL)
+    {
+      self->priv->queue_pool = g_ptr_array_new_with_free_func (g_object_unref);
+      g_ptr_array_add (self->priv->queue_pool, g_object_ref (queue));
+    }
+
+  if (self->priv->queue_selection == GOCL_QUEUE_SELECTION_LEAST_LOADED)
+    {
+      queue = select_least_loaded_queue (self);
+    }
+  else
+    {
+      guint index = self->priv->next_queue;
+
+      self->priv->next_queue = (index + 1) % self->priv->queue_pool_size;
+
+      if (index < self->priv->queue_pool->len)
+        queue = g_ptr_array_index (self->priv->queue_pool, index);
+      else
+        queue = add_pool_queue (self);
+    }
+
+  g_mutex_unlock (&self->priv->queue_pool_mutex);
+
+  return queue;
+}
+
 /**
  * gocl_device_has_extension:
  * @self: The #GoclDevice
@@ -450,6 +704,128 @@ gocl_device_get_max_compute_units (GoclDevice *self)
   return (guint) max_compute_units;
 }
 
+/**
+ * gocl_device_partition_equally:
+ * @self: The #GoclDevice
+ * @compute_units: The number of compute units of each sub-device
+ *
+ * Partitions the device into as many sub-devices as possible, each one with
+ * @compute_units compute units. Compute units left over are not used by any
+ * sub-device.
+ *
+ * The sub-devices belong to a new #GoclContext that contains all of them,
+ * and is obtained with gocl_device_get_context(). Like for any other context,
+ * the buffers and programs used with the sub-devices must be created in it,
+ * and the programs built for it. Use gocl_device_get_parent() to obtain @self
+ * back from them.
+ *
+ * Returns: (transfer full) (element-type Gocl.Device): A list of newly
+ * created #GoclDevice objects, or %NULL on error. Free with
+ * g_list_free_full() and g_object_unref().
+ **/
+GList *
+gocl_device_partition_equally (GoclDevice *self, guint compute_units)
+{
+  cl_device_partition_property properties[3];
+
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), NULL);
+  g_return_val_if_fail (compute_units > 0, NULL);
+
+  properties[0] = CL_DEVICE_PARTITION_EQUALLY;
+  properties[1] = (cl_device_partition_property) compute_units;
+  properties[2] = 0;
+
+  return create_sub_devices (self, properties);
+}
+
+/**
+ * gocl_device_partition_by_counts:
+ * @self: The #GoclDevice
+ * @counts: (array length=n_counts): The number of compute units of each
+ * sub-device
+ * @n_counts: The length of @counts
+ *
+ * Partitions the device into @n_counts sub-devices, the i-th one with
+ * @counts[i] compute units. The total must not exceed the number of compute
+ * units of the device (see gocl_device_get_max_compute_units()).
+ *
+ * See gocl_device_partition_equally() for details about the sub-devices.
+ *
+ * Returns: (transfer full) (element-type Gocl.Device): A list of newly
+ * created #GoclDevice objects, in the same order as @counts, or %NULL on
+ * error. Free with g_list_free_full() and g_object_unref().
+ **/
+GList *
+gocl_device_partition_by_counts (GoclDevice  *self,
+                                 const guint *counts,
+                                 guint        n_counts)
+{
+  cl_device_partition_property *properties;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), NULL);
+  g_return_val_if_fail (counts != NULL, NULL);
+  g_return_val_if_fail (n_counts > 0, NULL);
+
+  properties = g_newa (cl_device_partition_property, n_counts + 3);
+
+  properties[0] = CL_DEVICE_PARTITION_BY_COUNTS;
+  for (i = 0; i < n_counts; i++)
+    properties[i + 1] = (cl_device_partition_property) counts[i];
+  properties[n_counts + 1] = CL_DEVICE_PARTITION_BY_COUNTS_LIST_END;
+  properties[n_counts + 2] = 0;
+
+  return create_sub_devices (self, properties);
+}
+
+/**
+ * gocl_device_partition_by_affinity:
+ * @self: The #GoclDevice
+ * @domain: A value from #GoclAffinityDomain
+ *
+ * Partitions the device into one sub-device per group of compute units that
+ * share the NUMA node or cache given by @domain. On a host with two NUMA
+ * nodes, for example, %GOCL_AFFINITY_DOMAIN_NUMA gives one sub-device per
+ * node, so that the kernels running on each one access memory local to it.
+ *
+ * See gocl_device_partition_equally() for details about the sub-devices.
+ *
+ * Returns: (transfer full) (element-type Gocl.Device): A list of newly
+ * created #GoclDevice objects, or %NULL on error. Free with
+ * g_list_free_full() and g_object_unref().
+ **/
+GList *
+gocl_device_partition_by_affinity (GoclDevice         *self,
+                                   GoclAffinityDomain  domain)
+{
+  cl_device_partition_property properties[3];
+
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), NULL);
+
+  properties[0] = CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN;
+  properties[1] = (cl_device_partition_property) domain;
+  properties[2] = 0;
+
+  return create_sub_devices (self, properties);
+}
+
+/**
+ * gocl_device_get_parent:
+ * @self: The #GoclDevice
+ *
+ * Obtains the device @self was partitioned from, if it is a sub-device.
+ *
+ * Returns: (transfer none): The parent #GoclDevice, or %NULL if @self is not
+ * a sub-device
+ **/
+GoclDevice *
+gocl_device_get_parent (GoclDevice *self)
+{
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), NULL);
+
+  return self->priv->parent;
+}
+
 /**
  * gocl_device_acquire_gl_objects_sync:
  * @self: The #GoclDevice
@@ -532,19 +908,14 @@ gocl_device_acquire_gl_objects (GoclDevice  *self,
 
       error = gocl_error_get_last ();
 
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             NULL);
+      _event = gocl_event_new (queue, NULL);
       resolver_func = gocl_event_steal_resolver_func (_event);
       resolver_func (_event, error);
       g_error_free (error);
     }
   else
     {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             "event", event,
-                             NULL);
+      _event = gocl_event_new (queue, event);
       gocl_event_set_event_wait_list (_event, event_wait_list);
       gocl_event_steal_resolver_func (_event);
     }
@@ -631,19 +1002,14 @@ gocl_device_release_gl_objects (GoclDevice  *self,
 
       error = gocl_error_get_last ();
 
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             NULL);
+      _event = gocl_event_new (queue, NULL);
       resolver_func = gocl_event_steal_resolver_func (_event);
       resolver_func (_event, error);
       g_error_free (error);
     }
   else
     {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             "event", event,
-                             NULL);
+      _event = gocl_event_new (queue, event);
       gocl_event_set_event_wait_list (_event, event_wait_list);
       gocl_event_steal_resolver_func (_event);
     }
@@ -25,6 +25,7 @@
 #include <glib-object.h>
 #include <CL/opencl.h>
 
+#include "gocl-decls.h"
 #include "gocl-buffer.h"
 #include "gocl-queue.h"
 
@@ -61,11 +62,25 @@ gsize                  gocl_device_get_max_work_group_size    (GoclDevice  *self
 
 GoclQueue *            gocl_device_get_default_queue          (GoclDevice  *self);
 
+void                   gocl_device_set_queue_pool             (GoclDevice         *self,
+                                                               guint               size,
+                                                               GoclQueueSelection  selection);
+GoclQueue *            gocl_device_get_queue                  (GoclDevice  *self);
+
 gboolean               gocl_device_has_extension              (GoclDevice   *self,
                                                                const gchar  *extension_name);
 
 guint                  gocl_device_get_max_compute_units      (GoclDevice *self);
 
+GList *                gocl_device_partition_equally          (GoclDevice *self,
+                                                               guint       compute_units);
+GList *                gocl_device_partition_by_counts        (GoclDevice  *self,
+                                                               const guint *counts,
+                                                               guint        n_counts);
+GList *                gocl_device_partition_by_affinity      (GoclDevice         *self,
+                                                               GoclAffinityDomain  domain);
+GoclDevice *           gocl_device_get_parent                 (GoclDevice *self);
+
 gboolean               gocl_device_acquire_gl_objects_sync    (GoclDevice  *self,
                                                                GList       *object_list,
                                                                GList       *event_wait_list);
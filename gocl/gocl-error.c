@@ -31,7 +31,35 @@
 #include "gocl-error.h"
 #include "gocl-private.h"
 
-static GError *last_error = NULL;
+static void free_last_error (gpointer data);
+
+/* the last error is kept per thread, so that threads running Gocl operations
+   concurrently do not overwrite each other's error */
+static GPrivate last_error = G_PRIVATE_INIT (free_last_error);
+
+static void
+free_last_error (gpointer data)
+{
+  GError **error = data;
+
+  g_clear_error (error);
+  g_free (error);
+}
+
+static GError **
+get_last_error (void)
+{
+  GError **error;
+
+  error = g_private_get (&last_error);
+  if (error == NULL)
+    {
+      error = g_new0 (GError *, 1);
+      g_private_set (&last_error, error);
+    }
+
+  return error;
+}
 
 static const gchar *
 get_error_code_description (cl_int err_code)
@@ -120,11 +148,11 @@ gocl_error_check_opencl (cl_int err_code, GError **error)
 gboolean
 gocl_error_check_opencl_internal (cl_int err_code)
 {
-  g_clear_error (&last_error);
+  GError **error = gocl_error_prepare ();
 
   if (err_code != CL_SUCCESS)
     {
-      g_set_error_literal (&last_error,
+      g_set_error_literal (error,
                            GOCL_OPENCL_ERROR,
                            err_code,
                            get_error_code_description (err_code));
@@ -149,32 +177,38 @@ gocl_error_check_opencl_internal (cl_int err_code)
 GError **
 gocl_error_prepare (void)
 {
-  g_clear_error (&last_error);
+  GError **error = get_last_error ();
+
+  g_clear_error (error);
 
-  return &last_error;
+  return error;
 }
 
 /**
  * gocl_error_get_last:
  *
- * Retrieves the error that ocurred in the last Gocl operation, if any, or
- * %NULL if the last operation was successful.
+ * Retrieves the error that ocurred in the last Gocl operation of the calling
+ * thread, if any, or %NULL if the last operation was successful. Each thread
+ * has its own last error.
  *
  * Returns: (transfer full): A pointer to a newly created error, or %NULL
  **/
 GError *
 gocl_error_get_last (void)
 {
-  return g_error_copy (last_error);
+  GError *error = *get_last_error ();
+
+  return error != NULL ? g_error_copy (error) : NULL;
 }
 
 /**
  * gocl_error_free:
  *
- * Frees the internal Gocl error if it is not %NULL. Applications should
- * not normally need to ever call this function, except before the end of
- * execution of the program, to avoid leaking memory from a potential error
- * in the last Gocl operation.
+ * Frees the internal Gocl error of the calling thread if it is not %NULL.
+ * Applications should not normally need to ever call this function, except
+ * before the end of execution of the program, to avoid leaking memory from a
+ * potential error in the last Gocl operation. The errors of other threads are
+ * freed when those threads exit.
  **/
 void
 gocl_error_free (void)
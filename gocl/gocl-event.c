@@ -33,6 +33,15 @@
  *
  * A #GoclEvent is used by applications to get a notification when the
  * corresponding operation completes, by calling gocl_event_then().
+ * By default, the notification is delivered in the thread-default main
+ * context of the caller. Latency-sensitive code that does not need main loop
+ * affinity can use gocl_event_then_full() instead, to have the callback
+ * invoked directly on the notifying thread or on a pool of worker threads.
+ *
+ * Events returned by asynchronous operations are owned by Gocl, and released
+ * in an idle call of the thread-default main context. Applications that never
+ * iterate a main context should enable the headless mode with
+ * gocl_event_set_headless_mode(), and release the events themselves.
  *
  * #GoclEvent's are also the building blocks of synchronization
  * in OpenCL. The application developer will notice that most operations
@@ -46,6 +55,28 @@
  * the command queue where the operation represented by the event was
  * originally queued. The #GoclQueue can be retrieved using
  * gocl_event_get_queue().
+ *
+ * If the #GoclQueue was created with the %GOCL_QUEUE_FLAGS_PROFILING flag,
+ * the timestamps of the different stages of the operation can be retrieved
+ * once the event triggered, using gocl_event_get_profiling_info(). For
+ * convenience, gocl_event_get_queue_wait_time() and
+ * gocl_event_get_execution_time() provide the most commonly used intervals.
+ *
+ * To block the calling thread until an event triggers, gocl_event_wait() and
+ * gocl_event_wait_all() are provided. Both accept a timeout, and can poll the
+ * status of the command for a short time before sleeping, as configured with
+ * gocl_event_set_wait_spin_time().
+ *
+ * To synchronize with a set of events at once, gocl_event_all() and
+ * gocl_event_any() combine them into a single #GoclEvent that triggers when
+ * all, or the first, of the events complete. This way, waiting for many
+ * operations costs a single notification.
+ *
+ * Events created by Gocl operations are recycled: when the last reference
+ * to one is dropped, it is reset and kept in a small pool owned by its
+ * #GoclQueue, to be reused by the next operation enqueued there. Signal
+ * handlers and weak references are dropped at that point, and events that
+ * still carry data set with g_object_set_data() are not recycled.
  **/
 
 /**
@@ -79,6 +110,7 @@
  **/
 
 #include <string.h>
+#include <gio/gio.h>
 
 #include "gocl-event.h"
 
@@ -94,30 +126,115 @@ struct _GoclEventPrivate
   GError *error;
   GoclEventResolverFunc resolver_func;
 
-  GMainContext *context;
   GMutex mutex;
+  GCond cond;
   gboolean already_resolved;
   gboolean waiting_event;
 
   GList *closure_list;
-  GThread *thread;
 
-  gint complete_src_id;
   gint unref_src_id;
 
   gboolean is_user_event;
+  gboolean in_flight;
 
   GList *event_wait_list;
+
+  gboolean has_profiling_info;
+  cl_ulong profiling_info[4];
 };
 
 typedef struct
 {
   GoclEventCallback callback;
   gpointer user_data;
+  GoclEventDispatch dispatch;
   GMainContext *context;
   GoclEvent *self;
 } Closure;
 
+/* A watcher is a thread that multiplexes many pending cl_event's, so that
+   waiting for completion does not cost one thread per event */
+typedef struct
+{
+  GThread *thread;
+  GMutex mutex;
+  GCond cond;
+  GPtrArray *pending;
+  gboolean woken_up;
+} Watcher;
+
+/* state shared by the source events of gocl_event_all() and gocl_event_any() */
+typedef struct
+{
+  GoclEvent *event;
+  GoclEventResolverFunc resolver_func;
+  gboolean wait_all;
+
+  GMutex mutex;
+  guint pending;
+  gboolean resolved;
+  GError *error;
+} Aggregate;
+
+/* a command enqueued by gocl_event_enqueue_task(), held behind a user event
+   (the gate) until its dependencies complete, so that it can be cancelled */
+typedef struct
+{
+  gint ref_count;
+
+  GTask *task;
+  GCancellable *cancellable;
+  gulong cancelled_id;
+
+  cl_event gate;
+
+  GMutex mutex;
+  gint state;
+  guint pending;
+} GatedCommand;
+
+enum
+{
+  GATED_COMMAND_STATE_GATED,
+  GATED_COMMAND_STATE_SUBMITTED,
+  GATED_COMMAND_STATE_CANCELLED
+};
+
+/* status given to the gate of a cancelled command, which makes OpenCL
+   terminate the command instead of executing it */
+#define GATE_CANCELLED_STATUS -1
+
+/* status given to the user event of a #GoclEvent resolved with an error, so
+   that commands waiting for it fail instead of running */
+#define USER_EVENT_FAILED_STATUS -1
+
+#define DEFAULT_WATCHER_POOL_SIZE 1
+#define MAX_WATCHER_POOL_SIZE     16
+
+/* time in microseconds a watcher sleeps before polling its events again, when
+   no completion wakes it up earlier */
+#define WATCHER_POLL_INTERVAL 1000
+
+static Watcher watchers[MAX_WATCHER_POOL_SIZE];
+static guint watcher_pool_size = DEFAULT_WATCHER_POOL_SIZE;
+static guint next_watcher = 0;
+static GMutex watchers_mutex;
+
+/* worker threads for closures using GOCL_EVENT_DISPATCH_WORKER */
+static GThreadPool *dispatch_pool = NULL;
+static GMutex dispatch_pool_mutex;
+
+/* in headless mode, events are owned by the caller and notifications that
+   have no main context to go to are delivered by a dispatcher thread */
+static gint headless_mode = FALSE;
+static GMainContext *dispatcher_context = NULL;
+static GMutex dispatcher_mutex;
+
+/* time in microseconds that gocl_event_wait() polls the status of an event
+   before blocking */
+static gint wait_spin_time = 0;
+
 /* properties */
 enum
 {
@@ -152,6 +269,8 @@ static guint          timeout_add                      (GMainContext *context,
                                                         GSourceFunc   callback,
                                                         gpointer      user_data);
 
+static void           setup_event                      (GoclEvent *self);
+
 static void           event_on_notify                  (cl_event event,
                                                         cl_int   event_command_exec_status,
                                                         gpointer user_data);
@@ -203,33 +322,63 @@ gocl_event_init (GoclEvent *self)
   priv->error = NULL;
   priv->resolver_func = gocl_event_resolve;
 
-  priv->context = g_main_context_get_thread_default ();
   g_mutex_init (&priv->mutex);
+  g_cond_init (&priv->cond);
   priv->already_resolved = FALSE;
   priv->waiting_event = FALSE;
 
   priv->closure_list = NULL;
-  priv->thread = NULL;
 
-  priv->complete_src_id = 0;
   priv->unref_src_id = 0;
 
   priv->is_user_event = TRUE;
+  priv->in_flight = FALSE;
 
   priv->event_wait_list = NULL;
+
+  priv->has_profiling_info = FALSE;
 }
 
-static void
-gocl_event_dispose (GObject *obj)
+static gboolean
+recycle (GoclEvent *self, GoclQueue *queue)
 {
-  GoclEvent *self = GOCL_EVENT (obj);
+  GoclEventPrivate *priv = self->priv;
+  GData *qdata = G_OBJECT (self)->qdata;
+
+  /* an event with notifications still in flight cannot be reused */
+  if (priv->closure_list != NULL)
+    return FALSE;
 
-  if (self->priv->queue != NULL)
+  /* disposing the parent already dropped signal handlers and weak references,
+     but data attached to the object would leak into its next use */
+  if (((gsize) qdata & ~(gsize) G_DATALIST_FLAGS_MASK) != 0)
+    return FALSE;
+
+  if (priv->event != NULL)
     {
-      g_object_unref (self->priv->queue);
-      self->priv->queue = NULL;
+      clReleaseEvent (priv->event);
+      priv->event = NULL;
     }
 
+  g_clear_error (&priv->error);
+  priv->resolver_func = gocl_event_resolve;
+
+  priv->already_resolved = FALSE;
+  priv->waiting_event = FALSE;
+  priv->unref_src_id = 0;
+  priv->is_user_event = TRUE;
+  priv->in_flight = FALSE;
+  priv->has_profiling_info = FALSE;
+
+  return gocl_queue_recycle_event (queue, self);
+}
+
+static void
+gocl_event_dispose (GObject *obj)
+{
+  GoclEvent *self = GOCL_EVENT (obj);
+  GoclQueue *queue = self->priv->queue;
+
   if (self->priv->event_wait_list != NULL)
     {
       g_list_free_full (self->priv->event_wait_list, g_object_unref);
@@ -237,6 +386,16 @@ gocl_event_dispose (GObject *obj)
     }
 
   G_OBJECT_CLASS (gocl_event_parent_class)->dispose (obj);
+
+  if (queue != NULL)
+    {
+      /* pooled events don't keep their queue alive */
+      self->priv->queue = NULL;
+
+      /* the pool takes a new reference, so the object is not finalized */
+      recycle (self, queue);
+      g_object_unref (queue);
+    }
 }
 
 static void
@@ -250,9 +409,6 @@ gocl_event_finalize (GObject *obj)
   if (self->priv->error != NULL)
     g_error_free (self->priv->error);
 
-  if (self->priv->thread != NULL)
-    g_thread_unref (self->priv->thread);
-
   if (self->priv->closure_list != NULL)
     {
       /* @TODO: should we call any awaiting closure? */
@@ -260,12 +416,7 @@ gocl_event_finalize (GObject *obj)
     }
 
   g_mutex_clear (&self->priv->mutex);
-
-  if (self->priv->complete_src_id != 0)
-    {
-      g_source_remove (self->priv->complete_src_id);
-      self->priv->complete_src_id = 0;
-    }
+  g_cond_clear (&self->priv->cond);
 
   G_OBJECT_CLASS (gocl_event_parent_class)->finalize (obj);
 }
@@ -273,8 +424,22 @@ gocl_event_finalize (GObject *obj)
 static void
 gocl_event_constructed (GObject *obj)
 {
-  GoclEvent *self = GOCL_EVENT (obj);
+  setup_event (GOCL_EVENT (obj));
+}
+
+static void
+setup_event (GoclEvent *self)
+{
   cl_int err_code;
+  gboolean is_command = self->priv->event != NULL;
+
+  /* events of commands executed on the host, like native kernels, have no
+     OpenCL counterpart, and are only triggered by their resolver */
+  if (self->priv->event == NULL && self->priv->queue == NULL)
+    {
+      self->priv->is_user_event = FALSE;
+      return;
+    }
 
   if (self->priv->event == NULL)
     {
@@ -291,11 +456,23 @@ gocl_event_constructed (GObject *obj)
         self->priv->is_user_event = TRUE;
     }
 
+  /* the callback holds a reference, so that the event cannot be recycled
+     before it is notified */
   err_code = clSetEventCallback (self->priv->event,
                                  CL_COMPLETE,
                                  event_on_notify,
-                                 self);
-  gocl_error_check_opencl_internal (err_code);
+                                 g_object_ref (self));
+  if (gocl_error_check_opencl_internal (err_code))
+    {
+      g_object_unref (self);
+    }
+  else if (is_command)
+    {
+      /* the command counts towards the load of its queue until the event
+         is resolved */
+      self->priv->in_flight = TRUE;
+      gocl_queue_add_pending_commands (self->priv->queue, 1);
+    }
 }
 
 static void
@@ -386,10 +563,9 @@ free_closure (gpointer user_data)
   g_slice_free (Closure, closure);
 }
 
-static gboolean
-notify_event_completed_in_caller_context (gpointer user_data)
+static void
+run_closure (Closure *closure)
 {
-  Closure *closure = user_data;
   GoclEvent *self = closure->self;
 
   closure->callback (closure->self,
@@ -397,48 +573,137 @@ notify_event_completed_in_caller_context (gpointer user_data)
                      closure->user_data);
 
   free_closure (closure);
+}
+
+static gboolean
+notify_event_completed_in_caller_context (gpointer user_data)
+{
+  run_closure (user_data);
 
   return FALSE;
 }
 
-static gboolean
-event_completed (gpointer user_data)
+static void
+dispatch_pool_func (gpointer data, gpointer user_data)
 {
-  GoclEvent *self = GOCL_EVENT (user_data);
+  run_closure (data);
+}
 
-  g_mutex_lock (&self->priv->mutex);
+static gpointer
+dispatcher_thread_func (gpointer user_data)
+{
+  GMainContext *context = user_data;
+  GMainLoop *loop;
 
-  self->priv->complete_src_id = 0;
+  g_main_context_push_thread_default (context);
 
-  self->priv->already_resolved = TRUE;
-  self->priv->waiting_event = FALSE;
+  loop = g_main_loop_new (context, FALSE);
+  g_main_loop_run (loop);
 
-  GList *node = self->priv->closure_list;
-  while (node != NULL)
+  return NULL;
+}
+
+static GMainContext *
+get_dispatcher_context (void)
+{
+  g_mutex_lock (&dispatcher_mutex);
+
+  if (dispatcher_context == NULL)
+    {
+      dispatcher_context = g_main_context_new ();
+      g_thread_unref (g_thread_new ("gocl-event-dispatcher",
+                                    dispatcher_thread_func,
+                                    dispatcher_context));
+    }
+
+  g_mutex_unlock (&dispatcher_mutex);
+
+  return dispatcher_context;
+}
+
+static void
+dispatch_closure (Closure *closure)
+{
+  switch (closure->dispatch)
     {
-      Closure *closure = node->data;
+    case GOCL_EVENT_DISPATCH_DIRECT:
+      run_closure (closure);
+      break;
 
+    case GOCL_EVENT_DISPATCH_WORKER:
+      g_mutex_lock (&dispatch_pool_mutex);
+      if (dispatch_pool == NULL)
+        dispatch_pool = g_thread_pool_new (dispatch_pool_func,
+                                           NULL,
+                                           g_get_num_processors (),
+                                           FALSE,
+                                           NULL);
+      g_mutex_unlock (&dispatch_pool_mutex);
+
+      g_thread_pool_push (dispatch_pool, closure, NULL);
+      break;
+
+    default:
       timeout_add (closure->context,
                    0,
                    G_PRIORITY_DEFAULT,
                    notify_event_completed_in_caller_context,
                    closure);
-
-      node = g_list_next (node);
+      break;
     }
+}
 
-  g_list_free (self->priv->closure_list);
-  self->priv->closure_list = NULL;
+/* Marks the event as resolved with @error (taking ownership of it) and
+   dispatches the pending closures. This runs on whatever thread first
+   observes the completion, and only the first call has any effect */
+static void
+event_completed (GoclEvent *self, GError *error)
+{
+  GList *closure_list;
+  GList *event_wait_list;
+  GList *node;
+  gboolean in_flight;
 
-  if (self->priv->event_wait_list != NULL)
+  g_mutex_lock (&self->priv->mutex);
+
+  if (self->priv->already_resolved)
     {
-      g_list_free_full (self->priv->event_wait_list, g_object_unref);
-      self->priv->event_wait_list = NULL;
+      g_mutex_unlock (&self->priv->mutex);
+
+      if (error != NULL)
+        g_error_free (error);
+
+      return;
     }
 
+  self->priv->error = error;
+  self->priv->already_resolved = TRUE;
+  self->priv->waiting_event = FALSE;
+
+  closure_list = self->priv->closure_list;
+  self->priv->closure_list = NULL;
+
+  event_wait_list = self->priv->event_wait_list;
+  self->priv->event_wait_list = NULL;
+
+  in_flight = self->priv->in_flight;
+  self->priv->in_flight = FALSE;
+
+  g_cond_broadcast (&self->priv->cond);
+
   g_mutex_unlock (&self->priv->mutex);
 
-  return FALSE;
+  if (in_flight)
+    gocl_queue_add_pending_commands (self->priv->queue, -1);
+
+  /* closures are dispatched out of the lock, since direct ones may call
+     back into the event */
+  for (node = closure_list; node != NULL; node = node->next)
+    dispatch_closure (node->data);
+  g_list_free (closure_list);
+
+  if (event_wait_list != NULL)
+    g_list_free_full (event_wait_list, g_object_unref);
 }
 
 static void
@@ -449,17 +714,11 @@ event_on_notify (cl_event event,
   GoclEvent *self = GOCL_EVENT (user_data);
   GError *error = NULL;
 
-  g_mutex_lock (&self->priv->mutex);
-
-  if (gocl_error_check_opencl (event_command_exec_status, &error))
-    self->priv->error = error;
+  gocl_error_check_opencl (event_command_exec_status, &error);
+  event_completed (self, error);
 
-  self->priv->complete_src_id = timeout_add (self->priv->context,
-                                             0,
-                                             G_PRIORITY_DEFAULT,
-                                             event_completed,
-                                             self);
-  g_mutex_unlock (&self->priv->mutex);
+  /* drop the reference held by the OpenCL callback */
+  g_object_unref (self);
 }
 
 static void
@@ -468,139 +727,696 @@ gocl_event_resolve (GoclEvent *self, GError *error)
   g_return_if_fail (GOCL_IS_EVENT (self));
   g_return_if_fail (! self->priv->already_resolved);
 
-  g_mutex_lock (&self->priv->mutex);
-
-  if (error != NULL)
-    self->priv->error = g_error_copy (error);
-
-  self->priv->complete_src_id = timeout_add (self->priv->context,
-                                             0,
-                                             G_PRIORITY_DEFAULT,
-                                             event_completed,
-                                             self);
-
-  g_mutex_unlock (&self->priv->mutex);
+  event_completed (self, error != NULL ? g_error_copy (error) : NULL);
 
   if (self->priv->is_user_event)
     {
       cl_int err_code;
       GError *cl_error = NULL;
 
-      err_code = clSetUserEventStatus (self->priv->event, CL_COMPLETE);
+      err_code = clSetUserEventStatus (self->priv->event,
+                                       error != NULL ?
+                                       USER_EVENT_FAILED_STATUS :
+                                       CL_COMPLETE);
       if (gocl_error_check_opencl (err_code, &cl_error))
         {
-          g_warning ("Error resolving OpenCL user event: %s\n", error->message);
-          g_error_free (error);
+          g_warning ("Error resolving OpenCL user event: %s\n",
+                     cl_error->message);
+          g_error_free (cl_error);
         }
     }
 }
 
-/* calling clWaitForEvents from a thread is oddly necessary because otherwise
-   the event callback doesn't trigger in AMD APP SDK platform */
+static gboolean
+cl_event_is_complete (cl_event event)
+{
+  cl_int status;
+  cl_int err_code;
+
+  err_code = clGetEventInfo (event,
+                             CL_EVENT_COMMAND_EXECUTION_STATUS,
+                             sizeof (cl_int),
+                             &status,
+                             NULL);
+
+  /* a negative status means the command terminated abnormally */
+  return err_code != CL_SUCCESS || status <= CL_COMPLETE;
+}
+
+static void
+watcher_wake_up (Watcher *watcher)
+{
+  g_mutex_lock (&watcher->mutex);
+  watcher->woken_up = TRUE;
+  g_cond_signal (&watcher->cond);
+  g_mutex_unlock (&watcher->mutex);
+}
+
+static void
+watcher_on_event_complete (cl_event event,
+                           cl_int   event_command_exec_status,
+                           gpointer user_data)
+{
+  watcher_wake_up (user_data);
+}
+
+/* querying the events from a thread is oddly necessary because otherwise
+   the event callback doesn't trigger in AMD APP SDK platform. Each watcher
+   drops the events that already completed and then sleeps until any of the
+   remaining ones completes, a new event is submitted, or the poll interval
+   expires, so that a slow command does not delay noticing the others */
 static gpointer
-wait_event_thread_func (gpointer user_data)
+watcher_thread_func (gpointer user_data)
 {
-  GoclEvent *self = GOCL_EVENT (user_data);
+  Watcher *watcher = user_data;
+  GPtrArray *batch;
+  guint i;
+
+  batch = g_ptr_array_new ();
+
+  while (TRUE)
+    {
+      g_mutex_lock (&watcher->mutex);
+
+      if (batch->len > 0 && ! watcher->woken_up)
+        g_cond_wait_until (&watcher->cond,
+                           &watcher->mutex,
+                           g_get_monotonic_time () + WATCHER_POLL_INTERVAL);
+
+      while (watcher->pending->len == 0 && batch->len == 0)
+        g_cond_wait (&watcher->cond, &watcher->mutex);
+
+      watcher->woken_up = FALSE;
 
-  g_assert (self->priv->event != NULL);
+      for (i = 0; i < watcher->pending->len; i++)
+        g_ptr_array_add (batch, g_ptr_array_index (watcher->pending, i));
+      g_ptr_array_set_size (watcher->pending, 0);
 
-  clWaitForEvents (1, &self->priv->event);
+      g_mutex_unlock (&watcher->mutex);
+
+      i = 0;
+      while (i < batch->len)
+        {
+          cl_event event = g_ptr_array_index (batch, i);
+
+          if (cl_event_is_complete (event))
+            {
+              clReleaseEvent (event);
+              g_ptr_array_remove_index (batch, i);
+            }
+          else
+            {
+              i++;
+            }
+        }
+    }
 
   return NULL;
 }
 
-static gboolean
-unref_in_idle (gpointer user_data)
+static void
+watch_event (cl_event event)
 {
-  GoclEvent *self = GOCL_EVENT (user_data);
+  Watcher *watcher;
 
-  g_object_unref (self);
+  g_mutex_lock (&watchers_mutex);
 
-  return FALSE;
-}
+  watcher = &watchers[next_watcher];
+  next_watcher = (next_watcher + 1) % watcher_pool_size;
 
-/* public */
+  if (watcher->thread == NULL)
+    {
+      g_mutex_init (&watcher->mutex);
+      g_cond_init (&watcher->cond);
+      watcher->pending = g_ptr_array_new ();
+      watcher->woken_up = FALSE;
+
+      watcher->thread = g_thread_new ("gocl-event-watcher",
+                                      watcher_thread_func,
+                                      watcher);
+    }
 
-/**
- * gocl_event_get_event:
- * @self: The #GoclEvent
- *
- * Retrieves the OpenCL internal #cl_event object. This is a rather
- * low-level method that should not normally be called by applications.
- *
- * Returns: (transfer none) (type guint64): The internal #cl_event object
- **/
-cl_event
-gocl_event_get_event (GoclEvent *self)
-{
-  g_return_val_if_fail (GOCL_IS_EVENT (self), NULL);
+  g_mutex_unlock (&watchers_mutex);
 
-  return self->priv->event;
+  clRetainEvent (event);
+
+  g_mutex_lock (&watcher->mutex);
+  g_ptr_array_add (watcher->pending, event);
+  watcher->woken_up = TRUE;
+  g_cond_signal (&watcher->cond);
+  g_mutex_unlock (&watcher->mutex);
+
+  /* if the callback cannot be set, the event is still noticed by polling */
+  clSetEventCallback (event,
+                      CL_COMPLETE,
+                      watcher_on_event_complete,
+                      watcher);
 }
 
-/**
- * gocl_event_get_queue:
- * @self: The #GoclEvent
- *
- * Retrieves the #GoclQueue object where the operation that created this
- * event was queued.
- *
- * Returns: (transfer none): The #GoclQueue associated with the event
- **/
-GoclQueue *
-gocl_event_get_queue (GoclEvent *self)
+static void
+free_aggregate (Aggregate *aggr)
 {
-  g_return_val_if_fail (GOCL_IS_EVENT (self), NULL);
+  g_object_unref (aggr->event);
 
-  return self->priv->queue;
+  if (aggr->error != NULL)
+    g_error_free (aggr->error);
+
+  g_mutex_clear (&aggr->mutex);
+
+  g_slice_free (Aggregate, aggr);
 }
 
-/**
- * gocl_event_steal_resolver_func: (skip)
- * @self: The #GoclEvent
- *
- * Steals the internal resolver function from this event and sets it to %NULL,
- * so that only the first caller is able to resolve this event. This is a rather
- * low-level method that should not normally be called by applications.
- *
- * This method is intended to secure the #GoclEvent, to guarantee that the
- * creator of the event has exclusive control over the triggering of the
- * event.
- *
- * Returns: (transfer none): The internal resolver function
- **/
-GoclEventResolverFunc
-gocl_event_steal_resolver_func (GoclEvent *self)
+static void
+aggregate_on_complete (GoclEvent *event,
+                       GError    *event_error,
+                       gpointer   user_data)
 {
-  GoclEventResolverFunc func;
+  Aggregate *aggr = user_data;
+  GError *error;
+  gboolean resolve = FALSE;
+  gboolean last;
 
-  g_return_val_if_fail (GOCL_IS_EVENT (self), NULL);
+  error = event_error != NULL ? g_error_copy (event_error) : NULL;
 
-  func = self->priv->resolver_func;
-  self->priv->resolver_func = NULL;
+  g_mutex_lock (&aggr->mutex);
 
-  return func;
-}
+  aggr->pending--;
+  last = aggr->pending == 0;
 
-/**
- * gocl_event_then:
- * @self: The #GoclEvent
- * @callback: (scope async): A callback with a #GoclEventCallback signature
- * @user_data: (allow-none): Arbitrary data to pass in @callback, or %NULL
- *
+  /* gocl_event_all() fails as soon as any of the events fails, while
+     gocl_event_any() resolves with whatever the first event reports */
+  if (! aggr->resolved)
+    {
+      if (! aggr->wait_all || error != NULL || last)
+        {
+          aggr->error = error;
+          error = NULL;
+          aggr->resolved = resolve = TRUE;
+        }
+    }
+
+  g_mutex_unlock (&aggr->mutex);
+
+  if (error != NULL)
+    g_error_free (error);
+
+  if (resolve)
+    aggr->resolver_func (aggr->event, aggr->error);
+
+  if (last)
+    free_aggregate (aggr);
+}
+
+static GoclEvent *
+aggregate_events (GList *event_list, gboolean wait_all)
+{
+  GoclEvent *_event;
+  Aggregate *aggr;
+  GList *node;
+
+  _event = gocl_event_new (gocl_event_get_queue (event_list->data), NULL);
+  gocl_event_set_event_wait_list (_event, event_list);
+
+  aggr = g_slice_new0 (Aggregate);
+  aggr->event = g_object_ref (_event);
+  aggr->resolver_func = gocl_event_steal_resolver_func (_event);
+  aggr->wait_all = wait_all;
+  g_mutex_init (&aggr->mutex);
+  aggr->pending = g_list_length (event_list);
+
+  /* the events are followed through their own resolution rather than their
+     cl_event, so that events resolved with an error by Gocl (like failed
+     enqueues or host commands) fail the aggregate too. Callbacks may fire
+     right away, and the last one frees 'aggr', so it cannot be accessed
+     after the last callback is registered */
+  node = event_list;
+  while (node != NULL)
+    {
+      GoclEvent *event = GOCL_EVENT (node->data);
+
+      node = g_list_next (node);
+
+      gocl_event_then_full (event,
+                            GOCL_EVENT_DISPATCH_DIRECT,
+                            aggregate_on_complete,
+                            aggr);
+    }
+
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
+
+static GatedCommand *
+gated_command_ref (GatedCommand *cmd)
+{
+  g_atomic_int_inc (&cmd->ref_count);
+
+  return cmd;
+}
+
+static void
+gated_command_unref (gpointer user_data)
+{
+  GatedCommand *cmd = user_data;
+
+  if (! g_atomic_int_dec_and_test (&cmd->ref_count))
+    return;
+
+  if (cmd->gate != NULL)
+    clReleaseEvent (cmd->gate);
+
+  if (cmd->task != NULL)
+    g_object_unref (cmd->task);
+
+  if (cmd->cancellable != NULL)
+    g_object_unref (cmd->cancellable);
+
+  g_mutex_clear (&cmd->mutex);
+
+  g_slice_free (GatedCommand, cmd);
+}
+
+static void
+gated_command_set_state (GatedCommand *cmd, gint state)
+{
+  gboolean changed = FALSE;
+
+  g_mutex_lock (&cmd->mutex);
+  if (cmd->state == GATED_COMMAND_STATE_GATED)
+    {
+      cmd->state = state;
+      changed = TRUE;
+    }
+  g_mutex_unlock (&cmd->mutex);
+
+  if (! changed)
+    return;
+
+  if (state == GATED_COMMAND_STATE_SUBMITTED)
+    clSetUserEventStatus (cmd->gate, CL_COMPLETE);
+  else
+    clSetUserEventStatus (cmd->gate, GATE_CANCELLED_STATUS);
+}
+
+static void
+gated_command_on_cancelled (GCancellable *cancellable, gpointer user_data)
+{
+  gated_command_set_state (user_data, GATED_COMMAND_STATE_CANCELLED);
+}
+
+static void
+gated_command_on_dependency_complete (cl_event event,
+                                      cl_int   event_command_exec_status,
+                                      gpointer user_data)
+{
+  GatedCommand *cmd = user_data;
+  gboolean open;
+
+  g_mutex_lock (&cmd->mutex);
+  cmd->pending--;
+  open = cmd->pending == 0;
+  g_mutex_unlock (&cmd->mutex);
+
+  if (open)
+    gated_command_set_state (cmd, GATED_COMMAND_STATE_SUBMITTED);
+
+  gated_command_unref (cmd);
+}
+
+/* the dispatcher thread is never running the 'cancelled' handler, so the
+   handler can be disconnected from there without deadlocking */
+static gboolean
+gated_command_disconnect_in_idle (gpointer user_data)
+{
+  GatedCommand *cmd = user_data;
+
+  g_cancellable_disconnect (cmd->cancellable, cmd->cancelled_id);
+  gated_command_unref (cmd);
+
+  return FALSE;
+}
+
+static void
+gated_command_on_complete (cl_event event,
+                           cl_int   event_command_exec_status,
+                           gpointer user_data)
+{
+  GatedCommand *cmd = user_data;
+  GError *error = NULL;
+  gboolean cancelled;
+  GTask *task;
+
+  g_mutex_lock (&cmd->mutex);
+  cancelled = cmd->state == GATED_COMMAND_STATE_CANCELLED;
+  task = cmd->task;
+  cmd->task = NULL;
+  g_mutex_unlock (&cmd->mutex);
+
+  /* once cancelled, this may run from within the 'cancelled' handler, where
+     disconnecting would deadlock, so it is deferred to the dispatcher
+     thread. Otherwise the handler would stay connected, holding 'cmd' and
+     the task, for as long as the cancellable lives */
+  if (cmd->cancelled_id != 0)
+    {
+      if (! g_cancellable_is_cancelled (cmd->cancellable))
+        g_cancellable_disconnect (cmd->cancellable, cmd->cancelled_id);
+      else
+        timeout_add (get_dispatcher_context (),
+                     0,
+                     G_PRIORITY_DEFAULT,
+                     gated_command_disconnect_in_idle,
+                     gated_command_ref (cmd));
+    }
+
+  if (cancelled)
+    g_task_return_new_error (task,
+                             G_IO_ERROR,
+                             G_IO_ERROR_CANCELLED,
+                             "Operation was cancelled");
+  else if (gocl_error_check_opencl (event_command_exec_status, &error))
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+
+  g_object_unref (task);
+  gated_command_unref (cmd);
+}
+
+/* checks the execution status of the command directly, and resolves the
+   event right away if it completed, without waiting for the OpenCL
+   callback */
+static gboolean
+poll_completion (GoclEvent *self)
+{
+  cl_int status;
+  cl_int err_code;
+  GError *error = NULL;
+
+  if (self->priv->event == NULL)
+    return FALSE;
+
+  err_code = clGetEventInfo (self->priv->event,
+                             CL_EVENT_COMMAND_EXECUTION_STATUS,
+                             sizeof (cl_int),
+                             &status,
+                             NULL);
+  if (err_code != CL_SUCCESS || status > CL_COMPLETE)
+    return FALSE;
+
+  gocl_error_check_opencl (status, &error);
+  event_completed (self, error);
+
+  return TRUE;
+}
+
+static gboolean
+wait_until (GoclEvent  *self,
+            gint64      spin_end_time,
+            gint64      end_time,
+            GError    **error)
+{
+  gboolean resolved;
+
+  g_mutex_lock (&self->priv->mutex);
+  resolved = self->priv->already_resolved;
+  g_mutex_unlock (&self->priv->mutex);
+
+  /* waiting on a command that never reaches the device would block forever,
+     so this flushes even inside a batch */
+  if (! resolved && self->priv->queue != NULL)
+    gocl_queue_flush (self->priv->queue);
+
+  /* spinning avoids the cost of sleeping and waking up again, for commands
+     that are expected to complete very soon */
+  while (! resolved && g_get_monotonic_time () < spin_end_time)
+    resolved = poll_completion (self);
+
+  if (! resolved)
+    {
+      g_mutex_lock (&self->priv->mutex);
+
+      if (self->priv->event != NULL && ! self->priv->waiting_event)
+        {
+          self->priv->waiting_event = TRUE;
+          watch_event (self->priv->event);
+        }
+
+      while (! self->priv->already_resolved)
+        {
+          if (end_time < 0)
+            g_cond_wait (&self->priv->cond, &self->priv->mutex);
+          else if (! g_cond_wait_until (&self->priv->cond,
+                                        &self->priv->mutex,
+                                        end_time))
+            break;
+        }
+
+      resolved = self->priv->already_resolved;
+
+      g_mutex_unlock (&self->priv->mutex);
+
+      if (! resolved)
+        resolved = poll_completion (self);
+    }
+
+  if (! resolved)
+    {
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_TIMED_OUT,
+                   "Timeout waiting for event to complete");
+      return FALSE;
+    }
+
+  if (self->priv->error != NULL)
+    {
+      g_propagate_error (error, g_error_copy (self->priv->error));
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+get_wait_end_times (gint64  timeout,
+                    gint64 *spin_end_time,
+                    gint64 *end_time)
+{
+  gint64 now;
+  gint64 spin_time;
+
+  now = g_get_monotonic_time ();
+
+  spin_time = g_atomic_int_get (&wait_spin_time);
+  if (timeout >= 0)
+    spin_time = MIN (spin_time, timeout);
+
+  *spin_end_time = now + spin_time;
+  *end_time = timeout >= 0 ? now + timeout : -1;
+}
+
+/* fills @error only when given, leaving the last error of the calling thread
+   untouched */
+static gboolean
+fetch_profiling_info (GoclEvent *self, GError **error)
+{
+  const cl_profiling_info params[4] = {
+    CL_PROFILING_COMMAND_QUEUED,
+    CL_PROFILING_COMMAND_SUBMIT,
+    CL_PROFILING_COMMAND_START,
+    CL_PROFILING_COMMAND_END
+  };
+  cl_int err_code;
+  guint i;
+
+  if (self->priv->has_profiling_info)
+    return TRUE;
+
+  for (i = 0; i < 4; i++)
+    {
+      err_code = clGetEventProfilingInfo (self->priv->event,
+                                          params[i],
+                                          sizeof (cl_ulong),
+                                          &self->priv->profiling_info[i],
+                                          NULL);
+      if (gocl_error_check_opencl (err_code, error))
+        return FALSE;
+    }
+
+  self->priv->has_profiling_info = TRUE;
+
+  return TRUE;
+}
+
+static gboolean
+unref_in_idle (gpointer user_data)
+{
+  GoclEvent *self = GOCL_EVENT (user_data);
+
+  g_object_unref (self);
+
+  return FALSE;
+}
+
+/* public */
+
+/**
+ * gocl_event_new: (skip)
+ * @queue: (allow-none): The #GoclQueue where the operation was enqueued, or
+ * %NULL for operations executed on the host
+ * @event: (allow-none): The #cl_event of the operation, or %NULL to create a
+ * user event
+ *
+ * Creates a #GoclEvent for @event, reusing one from the pool of @queue if
+ * available. The new #GoclEvent takes ownership of @event.
+ *
+ * If both @queue and @event are %NULL, the event has no OpenCL counterpart and
+ * is only triggered through its resolver function. Such events cannot be
+ * waited for by commands enqueued on a device.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: (transfer full): A #GoclEvent
+ **/
+GoclEvent *
+gocl_event_new (GoclQueue *queue, cl_event event)
+{
+  GoclEvent *self = NULL;
+
+  if (queue != NULL)
+    self = gocl_queue_take_pooled_event (queue);
+
+  if (self == NULL)
+    return g_object_new (GOCL_TYPE_EVENT,
+                         "queue", queue,
+                         "event", event,
+                         NULL);
+
+  self->priv->queue = g_object_ref (queue);
+  self->priv->event = event;
+
+  setup_event (self);
+
+  return self;
+}
+
+/**
+ * gocl_event_get_event:
+ * @self: The #GoclEvent
+ *
+ * Retrieves the OpenCL internal #cl_event object. This is a rather
+ * low-level method that should not normally be called by applications.
+ *
+ * Returns: (transfer none) (type guint64): The internal #cl_event object
+ **/
+cl_event
+gocl_event_get_event (GoclEvent *self)
+{
+  g_return_val_if_fail (GOCL_IS_EVENT (self), NULL);
+
+  return self->priv->event;
+}
+
+/**
+ * gocl_event_get_queue:
+ * @self: The #GoclEvent
+ *
+ * Retrieves the #GoclQueue object where the operation that created this
+ * event was queued.
+ *
+ * Returns: (transfer none): The #GoclQueue associated with the event
+ **/
+GoclQueue *
+gocl_event_get_queue (GoclEvent *self)
+{
+  g_return_val_if_fail (GOCL_IS_EVENT (self), NULL);
+
+  return self->priv->queue;
+}
+
+/**
+ * gocl_event_steal_resolver_func: (skip)
+ * @self: The #GoclEvent
+ *
+ * Steals the internal resolver function from this event and sets it to %NULL,
+ * so that only the first caller is able to resolve this event. This is a rather
+ * low-level method that should not normally be called by applications.
+ *
+ * This method is intended to secure the #GoclEvent, to guarantee that the
+ * creator of the event has exclusive control over the triggering of the
+ * event.
+ *
+ * Returns: (transfer none): The internal resolver function
+ **/
+GoclEventResolverFunc
+gocl_event_steal_resolver_func (GoclEvent *self)
+{
+  GoclEventResolverFunc func;
+
+  g_return_val_if_fail (GOCL_IS_EVENT (self), NULL);
+
+  func = self->priv->resolver_func;
+  self->priv->resolver_func = NULL;
+
+  return func;
+}
+
+/**
+ * gocl_event_then:
+ * @self: The #GoclEvent
+ * @callback: (scope async): A callback with a #GoclEventCallback signature
+ * @user_data: (allow-none): Arbitrary data to pass in @callback, or %NULL
+ *
  * Requests for a notification when the operation represented by this event
  * has finished. When this event triggers, @callback will be called
  * passing @user_data as argument, if provided.
  *
  * If the event already triggered when this method is called, the notification
  * is immediately scheduled as an idle call.
+ *
+ * Pending events are not waited for by a dedicated thread each. Instead, a
+ * small pool of watcher threads multiplexes all of them; its size can be
+ * changed with gocl_event_set_watcher_pool_size().
+ *
+ * This is equivalent to calling gocl_event_then_full() with
+ * %GOCL_EVENT_DISPATCH_MAIN_CONTEXT.
  **/
 void
 gocl_event_then (GoclEvent         *self,
                  GoclEventCallback  callback,
                  gpointer           user_data)
+{
+  gocl_event_then_full (self,
+                        GOCL_EVENT_DISPATCH_MAIN_CONTEXT,
+                        callback,
+                        user_data);
+}
+
+/**
+ * gocl_event_then_full:
+ * @self: The #GoclEvent
+ * @dispatch: A value from #GoclEventDispatch
+ * @callback: (scope async): A callback with a #GoclEventCallback signature
+ * @user_data: (allow-none): Arbitrary data to pass in @callback, or %NULL
+ *
+ * Like gocl_event_then(), but allows choosing where @callback is invoked.
+ *
+ * With %GOCL_EVENT_DISPATCH_DIRECT, @callback runs on the thread that
+ * observes the completion, which is normally an internal OpenCL thread,
+ * or the calling thread if the event already triggered. The callback
+ * must return quickly and must not block on other OpenCL commands.
+ * With %GOCL_EVENT_DISPATCH_WORKER, @callback runs on a shared pool of
+ * worker threads. Neither mode requires a running main loop.
+ **/
+void
+gocl_event_then_full (GoclEvent         *self,
+                      GoclEventDispatch  dispatch,
+                      GoclEventCallback  callback,
+                      gpointer           user_data)
 {
   Closure *closure;
+  gboolean already_resolved;
 
   g_return_if_fail (GOCL_IS_EVENT (self));
   g_return_if_fail (callback != NULL);
@@ -608,20 +1424,15 @@ gocl_event_then (GoclEvent         *self,
   closure = g_slice_new0 (Closure);
   closure->callback = callback;
   closure->user_data = user_data;
-  closure->context = g_main_context_get_thread_default ();
+  closure->dispatch = dispatch;
+  closure->context = dispatch == GOCL_EVENT_DISPATCH_MAIN_CONTEXT ?
+    gocl_event_get_main_context () : g_main_context_get_thread_default ();
   closure->self = g_object_ref (self);
 
   g_mutex_lock (&self->priv->mutex);
 
-  if (self->priv->already_resolved)
-    {
-      timeout_add (closure->context,
-                   0,
-                   G_PRIORITY_DEFAULT,
-                   notify_event_completed_in_caller_context,
-                   closure);
-    }
-  else
+  already_resolved = self->priv->already_resolved;
+  if (! already_resolved)
     {
       self->priv->closure_list = g_list_append (self->priv->closure_list,
                                                 closure);
@@ -629,13 +1440,14 @@ gocl_event_then (GoclEvent         *self,
       if (self->priv->event != NULL && ! self->priv->waiting_event)
         {
           self->priv->waiting_event = TRUE;
-          self->priv->thread = g_thread_new ("gocl-event-thread",
-                                             wait_event_thread_func,
-                                             self);
+          watch_event (self->priv->event);
         }
     }
 
   g_mutex_unlock (&self->priv->mutex);
+
+  if (already_resolved)
+    dispatch_closure (closure);
 }
 
 /**
@@ -721,6 +1533,112 @@ gocl_event_list_to_array (GList *event_list, guint *len)
   return event_arr;
 }
 
+/**
+ * gocl_event_array_to_cl_array: (skip)
+ * @events: (array length=len) (allow-none): An array of #GoclEvent objects
+ * @len: The length of @events
+ * @inline_array: A caller-provided array of at least
+ * %GOCL_EVENT_INLINE_WAIT_LIST_SIZE elements
+ *
+ * Like gocl_event_list_to_array(), but for an array of #GoclEvent's. When
+ * @len does not exceed %GOCL_EVENT_INLINE_WAIT_LIST_SIZE, the #cl_event's are
+ * stored in @inline_array so that no memory is allocated.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: (transfer none): %NULL if @len is zero, @inline_array if the
+ * events fit in it, or otherwise a newly allocated array that must be freed
+ * with g_free()
+ **/
+cl_event *
+gocl_event_array_to_cl_array (GoclEvent **events,
+                              guint       len,
+                              cl_event   *inline_array)
+{
+  cl_event *event_arr;
+  guint i;
+
+  if (len == 0)
+    return NULL;
+
+  if (len <= GOCL_EVENT_INLINE_WAIT_LIST_SIZE)
+    event_arr = inline_array;
+  else
+    event_arr = g_new (cl_event, len);
+
+  for (i = 0; i < len; i++)
+    event_arr[i] = events[i]->priv->event;
+
+  return event_arr;
+}
+
+/**
+ * gocl_event_get_main_context: (skip)
+ *
+ * Retrieves the #GMainContext where sources created on behalf of the calling
+ * thread should be attached: the thread-default context, or the context of
+ * the internal dispatcher thread if there is none and headless mode is
+ * enabled.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: (transfer none) (allow-none): A #GMainContext, or %NULL for the
+ * global default context
+ **/
+GMainContext *
+gocl_event_get_main_context (void)
+{
+  GMainContext *context;
+
+  context = g_main_context_get_thread_default ();
+
+  /* the global default context is probably never iterated by a headless
+     application */
+  if (context == NULL && g_atomic_int_get (&headless_mode))
+    context = get_dispatcher_context ();
+
+  return context;
+}
+
+/**
+ * gocl_event_new_from_enqueue: (skip)
+ * @queue: The #GoclQueue where the command was enqueued
+ * @err_code: The error code returned by the OpenCL enqueue function
+ * @event: The #cl_event of the command, if @err_code is %CL_SUCCESS
+ *
+ * Creates the #GoclEvent returned by an enqueue operation. If @err_code is an
+ * error, the event is created already resolved with that error. In both
+ * cases, the resolver function is stolen from the new event.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: (transfer full): A #GoclEvent
+ **/
+GoclEvent *
+gocl_event_new_from_enqueue (GoclQueue *queue,
+                             cl_int     err_code,
+                             cl_event   event)
+{
+  GoclEvent *self;
+  GError *error = NULL;
+  GoclEventResolverFunc resolver_func;
+
+  if (gocl_error_check_opencl (err_code, &error))
+    {
+      self = gocl_event_new (queue, NULL);
+      resolver_func = gocl_event_steal_resolver_func (self);
+      resolver_func (self, error);
+      g_error_free (error);
+    }
+  else
+    {
+      self = gocl_event_new (queue, event);
+      gocl_event_steal_resolver_func (self);
+    }
+
+  return self;
+}
+
 /**
  * gocl_event_idle_unref:
  * @self: The #GoclEvent
@@ -728,12 +1646,18 @@ gocl_event_list_to_array (GList *event_list, guint *len)
  * Schedules an object de-reference in an idle call.
  * This is a rather low-level method and should not normally be called by
  * applications.
+ *
+ * In headless mode (see gocl_event_set_headless_mode()) this method does
+ * nothing, and the reference is left to the caller.
  **/
 void
 gocl_event_idle_unref (GoclEvent *self)
 {
   g_return_if_fail (GOCL_IS_EVENT (self));
 
+  if (g_atomic_int_get (&headless_mode))
+    return;
+
   if (self->priv->unref_src_id != 0)
     return;
 
@@ -743,3 +1667,459 @@ gocl_event_idle_unref (GoclEvent *self)
                                           unref_in_idle,
                                           self);
 }
+
+/**
+ * gocl_event_set_watcher_pool_size:
+ * @size: The number of watcher threads, between 1 and 16
+ *
+ * Sets the maximum number of threads used to wait for the completion of
+ * events which have pending notifications requested with gocl_event_then().
+ * Events are distributed among the watchers in a round-robin fashion, and each
+ * watcher handles any number of events. The default is a single watcher
+ * thread, which is enough unless the platform serializes event completion
+ * across command queues.
+ *
+ * Watcher threads are created lazily, and are never destroyed. Reducing the
+ * pool size only stops new events from being assigned to the exceeding
+ * watchers.
+ **/
+void
+gocl_event_set_watcher_pool_size (guint size)
+{
+  g_return_if_fail (size > 0 && size <= MAX_WATCHER_POOL_SIZE);
+
+  g_mutex_lock (&watchers_mutex);
+
+  watcher_pool_size = size;
+  next_watcher = next_watcher % watcher_pool_size;
+
+  g_mutex_unlock (&watchers_mutex);
+}
+
+/**
+ * gocl_event_wait:
+ * @self: The #GoclEvent
+ * @timeout: The maximum time to wait in microseconds, or -1 to wait
+ * indefinitely
+ * @error: (out) (allow-none): A pointer to a #GError, or %NULL
+ *
+ * Blocks the calling thread until the event triggers, or @timeout
+ * microseconds elapse. A @timeout of 0 just checks whether the event
+ * already triggered.
+ *
+ * The status of the command is first polled for the time set with
+ * gocl_event_set_wait_spin_time(), and only then the thread goes to sleep.
+ * Notifications requested with gocl_event_then() are delivered as usual.
+ *
+ * Returns: %TRUE if the event triggered successfully. Otherwise %FALSE is
+ * returned, and @error is set to %G_IO_ERROR_TIMED_OUT on timeout, or to the
+ * error of the operation
+ **/
+gboolean
+gocl_event_wait (GoclEvent  *self,
+                 gint64      timeout,
+                 GError    **error)
+{
+  gint64 spin_end_time;
+  gint64 end_time;
+
+  g_return_val_if_fail (GOCL_IS_EVENT (self), FALSE);
+
+  get_wait_end_times (timeout, &spin_end_time, &end_time);
+
+  return wait_until (self, spin_end_time, end_time, error);
+}
+
+/**
+ * gocl_event_wait_all:
+ * @event_list: (element-type Gocl.Event) (allow-none): A #GList of
+ * #GoclEvent objects
+ * @timeout: The maximum time to wait in microseconds, or -1 to wait
+ * indefinitely
+ * @error: (out) (allow-none): A pointer to a #GError, or %NULL
+ *
+ * Blocks the calling thread until all the events in @event_list trigger, or
+ * @timeout microseconds elapse, following the same strategy as
+ * gocl_event_wait(). @timeout applies to the whole list.
+ *
+ * Returns: %TRUE if all the events triggered successfully. Otherwise %FALSE is
+ * returned, and @error is set to %G_IO_ERROR_TIMED_OUT on timeout, or to the
+ * error of the first failed operation found
+ **/
+gboolean
+gocl_event_wait_all (GList   *event_list,
+                     gint64   timeout,
+                     GError **error)
+{
+  gint64 spin_end_time;
+  gint64 end_time;
+  GList *node;
+
+  get_wait_end_times (timeout, &spin_end_time, &end_time);
+
+  for (node = event_list; node != NULL; node = node->next)
+    {
+      g_return_val_if_fail (GOCL_IS_EVENT (node->data), FALSE);
+
+      if (! wait_until (GOCL_EVENT (node->data),
+                        spin_end_time,
+                        end_time,
+                        error))
+        {
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+/**
+ * gocl_event_set_wait_spin_time:
+ * @spin_time: The polling time in microseconds
+ *
+ * Sets for how long gocl_event_wait() and gocl_event_wait_all() poll the
+ * execution status of a command before putting the calling thread to sleep.
+ * The default is 0, meaning no polling.
+ *
+ * For commands that complete within a few microseconds, like small kernels
+ * running on a CPU device, polling for a short time avoids the latency of
+ * sleeping and waking up again, at the cost of keeping a processor busy.
+ **/
+void
+gocl_event_set_wait_spin_time (guint spin_time)
+{
+  g_atomic_int_set (&wait_spin_time, MIN (spin_time, G_MAXINT));
+}
+
+/**
+ * gocl_event_set_headless_mode:
+ * @headless: %TRUE to enable headless mode, %FALSE to disable it
+ *
+ * Enables or disables the headless mode, intended for applications that never
+ * iterate a #GMainContext, like daemons and worker threads. This mode is
+ * global, and should be set before any operation is enqueued.
+ *
+ * By default, the #GoclEvent returned by asynchronous operations is released
+ * in an idle call of the thread-default main context, so it leaks if that
+ * context is never iterated. In headless mode, no idle call is scheduled:
+ * the caller owns the returned event and must release it with
+ * g_object_unref() when done. Pending notifications and the OpenCL command
+ * itself keep the event alive as long as needed, so it is safe to release it
+ * right after calling gocl_event_then().
+ *
+ * Also, notifications requested with %GOCL_EVENT_DISPATCH_MAIN_CONTEXT from a
+ * thread without a thread-default main context are delivered by a dispatcher
+ * thread owned by Gocl, instead of the global default main context.
+ **/
+void
+gocl_event_set_headless_mode (gboolean headless)
+{
+  g_atomic_int_set (&headless_mode, headless ? TRUE : FALSE);
+}
+
+/**
+ * gocl_event_get_headless_mode:
+ *
+ * Tells whether the headless mode is enabled. See
+ * gocl_event_set_headless_mode().
+ *
+ * Returns: %TRUE if headless mode is enabled, %FALSE otherwise
+ **/
+gboolean
+gocl_event_get_headless_mode (void)
+{
+  return g_atomic_int_get (&headless_mode);
+}
+
+/**
+ * gocl_event_get_profiling_info:
+ * @self: The #GoclEvent
+ * @queued: (out) (allow-none): Location for the time when the command was
+ * enqueued, or %NULL
+ * @submitted: (out) (allow-none): Location for the time when the command was
+ * submitted to the device, or %NULL
+ * @started: (out) (allow-none): Location for the time when the command started
+ * executing, or %NULL
+ * @ended: (out) (allow-none): Location for the time when the command finished
+ * executing, or %NULL
+ *
+ * Retrieves the profiling timestamps of the operation represented by this
+ * event, in nanoseconds, as reported by the device clock. Profiling info is
+ * only available if the #GoclQueue of the event was created with the
+ * %GOCL_QUEUE_FLAGS_PROFILING flag, and once the event has triggered.
+ * Events created internally by Gocl (for example, on enqueue errors) never
+ * carry profiling info.
+ *
+ * The timestamps are fetched from OpenCL only once and then cached.
+ *
+ * Returns: %TRUE on success, %FALSE if profiling info is not available
+ **/
+gboolean
+gocl_event_get_profiling_info (GoclEvent *self,
+                               guint64   *queued,
+                               guint64   *submitted,
+                               guint64   *started,
+                               guint64   *ended)
+{
+  g_return_val_if_fail (GOCL_IS_EVENT (self), FALSE);
+
+  if (! fetch_profiling_info (self, gocl_error_prepare ()))
+    return FALSE;
+
+  if (queued != NULL)
+    *queued = self->priv->profiling_info[0];
+  if (submitted != NULL)
+    *submitted = self->priv->profiling_info[1];
+  if (started != NULL)
+    *started = self->priv->profiling_info[2];
+  if (ended != NULL)
+    *ended = self->priv->profiling_info[3];
+
+  return TRUE;
+}
+
+/**
+ * gocl_event_get_queue_wait_time:
+ * @self: The #GoclEvent
+ *
+ * Retrieves the time the operation represented by this event spent waiting
+ * in the command queue, from the moment it was enqueued until it started
+ * executing on the device. See gocl_event_get_profiling_info() for the
+ * requirements for profiling info to be available.
+ *
+ * Returns: The queue wait time in nanoseconds, or 0 if profiling info is
+ * not available
+ **/
+guint64
+gocl_event_get_queue_wait_time (GoclEvent *self)
+{
+  g_return_val_if_fail (GOCL_IS_EVENT (self), 0);
+
+  if (! fetch_profiling_info (self, gocl_error_prepare ()))
+    return 0;
+
+  return self->priv->profiling_info[2] - self->priv->profiling_info[0];
+}
+
+/**
+ * gocl_event_get_execution_time:
+ * @self: The #GoclEvent
+ *
+ * Retrieves the time the operation represented by this event took to
+ * execute on the device. See gocl_event_get_profiling_info() for the
+ * requirements for profiling info to be available.
+ *
+ * Returns: The execution time in nanoseconds, or 0 if profiling info is
+ * not available
+ **/
+guint64
+gocl_event_get_execution_time (GoclEvent *self)
+{
+  g_return_val_if_fail (GOCL_IS_EVENT (self), 0);
+
+  if (! fetch_profiling_info (self, gocl_error_prepare ()))
+    return 0;
+
+  return self->priv->profiling_info[3] - self->priv->profiling_info[2];
+}
+
+/**
+ * gocl_event_all:
+ * @event_list: (element-type Gocl.Event): A non-empty #GList of #GoclEvent
+ * objects
+ *
+ * Creates a new #GoclEvent that triggers when all the events in
+ * @event_list have triggered. If any of the events fails, the returned event
+ * triggers immediately with the corresponding error, and the operations
+ * waiting for it in their @event_wait_list fail as well.
+ *
+ * The returned event is associated with the #GoclQueue of the first event in
+ * @event_list, and can be used as any other event, for example in the
+ * @event_wait_list argument of other operations. Using it in place of the
+ * individual events means a single notification is dispatched.
+ *
+ * Returns: (transfer none): A #GoclEvent aggregating @event_list
+ **/
+GoclEvent *
+gocl_event_all (GList *event_list)
+{
+  g_return_val_if_fail (event_list != NULL, NULL);
+
+  return aggregate_events (event_list, TRUE);
+}
+
+/**
+ * gocl_event_any:
+ * @event_list: (element-type Gocl.Event): A non-empty #GList of #GoclEvent
+ * objects
+ *
+ * Creates a new #GoclEvent that triggers as soon as any of the events in
+ * @event_list triggers, carrying the error of that event, if any.
+ *
+ * The returned event is associated with the #GoclQueue of the first event in
+ * @event_list. The events in @event_list are kept alive until the returned
+ * event triggers.
+ *
+ * Returns: (transfer none): A #GoclEvent aggregating @event_list
+ **/
+GoclEvent *
+gocl_event_any (GList *event_list)
+{
+  g_return_val_if_fail (event_list != NULL, NULL);
+
+  return aggregate_events (event_list, FALSE);
+}
+
+/**
+ * gocl_event_enqueue_task: (skip)
+ * @task: (transfer full): A #GTask to complete when the command finishes
+ * @queue: The #GoclQueue to enqueue the command in
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events the command should wait for, or %NULL
+ * @accesses: (array length=n_accesses) (allow-none): The buffers accessed by
+ * the command, or %NULL
+ * @n_accesses: The length of @accesses
+ * @enqueue_func: The function that actually enqueues the command
+ * @user_data: Arbitrary data passed to @enqueue_func
+ *
+ * Enqueues a command in @queue by calling @enqueue_func, holding it behind an
+ * OpenCL user event (the gate) which opens when all the events in
+ * @event_wait_list complete. If the #GCancellable of @task is cancelled while
+ * the gate is still closed, the command is terminated before it reaches the
+ * device and @task returns %G_IO_ERROR_CANCELLED. Otherwise, @task returns
+ * %TRUE or the error of the command once it completes.
+ *
+ * This is a rather low-level method used to implement the asynchronous
+ * variants of operations, and should not normally be called by applications.
+ **/
+void
+gocl_event_enqueue_task (GTask                  *task,
+                         GoclQueue              *queue,
+                         GList                  *event_wait_list,
+                         const GoclBufferAccess *accesses,
+                         guint                   n_accesses,
+                         GoclEventEnqueueFunc    enqueue_func,
+                         gpointer                user_data)
+{
+  GatedCommand *cmd;
+  GoclDevice *device;
+  cl_context context;
+  cl_event gate;
+  cl_event event;
+  cl_event *_event_wait_list;
+  guint event_wait_list_len;
+  cl_int err_code;
+  GError *error = NULL;
+  GCancellable *cancellable;
+  GList *node;
+
+  g_return_if_fail (G_IS_TASK (task));
+  g_return_if_fail (GOCL_IS_QUEUE (queue));
+  g_return_if_fail (enqueue_func != NULL);
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      g_object_unref (task);
+      return;
+    }
+
+  device = gocl_queue_get_device (queue);
+  context = gocl_context_get_context (gocl_device_get_context (device));
+
+  gate = clCreateUserEvent (context, &err_code);
+  if (gocl_error_check_opencl (err_code, &error))
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  /* the gate goes at the end of the wait list */
+  event_wait_list_len = g_list_length (event_wait_list);
+  _event_wait_list = g_new (cl_event, event_wait_list_len + 1);
+  node = event_wait_list;
+  for (event_wait_list_len = 0; node != NULL; node = node->next)
+    _event_wait_list[event_wait_list_len++] =
+      gocl_event_get_event (GOCL_EVENT (node->data));
+  _event_wait_list[event_wait_list_len] = gate;
+
+  err_code = gocl_queue_enqueue (queue,
+                                 accesses,
+                                 n_accesses,
+                                 event_wait_list_len + 1,
+                                 _event_wait_list,
+                                 &event,
+                                 enqueue_func,
+                                 user_data);
+  g_free (_event_wait_list);
+
+  if (gocl_error_check_opencl (err_code, &error))
+    {
+      clSetUserEventStatus (gate, CL_COMPLETE);
+      clReleaseEvent (gate);
+
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  cmd = g_slice_new0 (GatedCommand);
+  cmd->ref_count = 1;
+  cmd->task = task;
+  cmd->gate = gate;
+  g_mutex_init (&cmd->mutex);
+  cmd->state = GATED_COMMAND_STATE_GATED;
+  cmd->pending = event_wait_list_len;
+
+  /* connected before the completion callback is set, so that the handler is
+     always known by the time the command completes */
+  cancellable = g_task_get_cancellable (task);
+  if (cancellable != NULL)
+    {
+      cmd->cancellable = g_object_ref (cancellable);
+      cmd->cancelled_id =
+        g_cancellable_connect (cancellable,
+                               G_CALLBACK (gated_command_on_cancelled),
+                               gated_command_ref (cmd),
+                               gated_command_unref);
+    }
+
+  err_code = clSetEventCallback (event,
+                                 CL_COMPLETE,
+                                 gated_command_on_complete,
+                                 gated_command_ref (cmd));
+  if (err_code != CL_SUCCESS)
+    {
+      gated_command_on_complete (event, err_code, cmd);
+      clReleaseEvent (event);
+
+      /* the task already returned the error, so the command must not run */
+      gated_command_set_state (cmd, GATED_COMMAND_STATE_CANCELLED);
+      gated_command_unref (cmd);
+      return;
+    }
+
+  watch_event (event);
+  clReleaseEvent (event);
+
+  if (event_wait_list_len == 0)
+    {
+      gated_command_set_state (cmd, GATED_COMMAND_STATE_SUBMITTED);
+    }
+  else
+    {
+      for (node = event_wait_list; node != NULL; node = node->next)
+        {
+          event = gocl_event_get_event (GOCL_EVENT (node->data));
+
+          err_code = clSetEventCallback (event,
+                                         CL_COMPLETE,
+                                         gated_command_on_dependency_complete,
+                                         gated_command_ref (cmd));
+          if (err_code != CL_SUCCESS)
+            gated_command_on_dependency_complete (event, err_code, cmd);
+        }
+    }
+
+  gated_command_unref (cmd);
+}
@@ -26,6 +26,7 @@
 #include <CL/opencl.h>
 
 #include "gocl-queue.h"
+#include "gocl-decls.h"
 
 G_BEGIN_DECLS
 
@@ -67,6 +68,39 @@ GoclEventResolverFunc  gocl_event_steal_resolver_func        (GoclEvent *self);
 void                   gocl_event_then                       (GoclEvent         *self,
                                                               GoclEventCallback  callback,
                                                               gpointer           user_data);
+void                   gocl_event_then_full                  (GoclEvent         *self,
+                                                              GoclEventDispatch  dispatch,
+                                                              GoclEventCallback  callback,
+                                                              gpointer           user_data);
+
+gboolean               gocl_event_wait                       (GoclEvent  *self,
+                                                              gint64      timeout,
+                                                              GError    **error);
+gboolean               gocl_event_wait_all                   (GList   *event_list,
+                                                              gint64   timeout,
+                                                              GError **error);
+void                   gocl_event_set_wait_spin_time         (guint spin_time);
+
+void                   gocl_event_set_watcher_pool_size      (guint size);
+
+void                   gocl_event_set_headless_mode          (gboolean headless);
+gboolean               gocl_event_get_headless_mode          (void);
+
+GoclEvent *            gocl_event_all                        (GList *event_list);
+GoclEvent *            gocl_event_any                        (GList *event_list);
+
+gboolean               gocl_event_get_profiling_info         (GoclEvent *self,
+                                                              guint64   *queued,
+                                                              guint64   *submitted,
+                                                              guint64   *started,
+                                                              guint64   *ended);
+guint64                gocl_event_get_queue_wait_time        (GoclEvent *self);
+guint64                gocl_event_get_execution_time         (GoclEvent *self);
+
+GoclEvent *            gocl_queue_enqueue_marker             (GoclQueue *self,
+                                                              GList     *event_wait_list);
+GoclEvent *            gocl_queue_enqueue_barrier            (GoclQueue *self,
+                                                              GList     *event_wait_list);
 
 /* these methods should eventually be moved to a private header file,
    since they are not supposed to be called by applications */
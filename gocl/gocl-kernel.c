@@ -41,9 +41,10 @@
  * Once all arguments are set, the kernel is ready to be executed on a device.
  * For this, the gocl_kernel_run_in_device() is used for non-blocking execution,
  * and gocl_kernel_run_in_device_sync() for a blocking version. Notice that
- * these methods will use the device's default command queue. In the future,
- * methods will be provided to run the kernel on arbitrary command queues
- * as well.
+ * these methods will use the device's default command queue. To run the kernel
+ * on a different queue, for example one obtained from the queue pool of the
+ * device with gocl_device_get_queue(), gocl_kernel_run_in_queue() and
+ * gocl_kernel_run_in_queue_sync() are provided.
  **/
 
 /**
@@ -53,16 +54,82 @@
  * The class for #GoclKernel objects.
  **/
 
+/**
+ * GoclNativeKernelFunc:
+ * @kernel: The #GoclKernel being executed
+ * @global_work_offset: (array fixed-size=3): The first global ID of each
+ * dimension to process
+ * @global_work_size: (array fixed-size=3): The number of global IDs of each
+ * dimension to process
+ * @user_data: The arbitrary pointer passed in gocl_program_add_native_kernel()
+ *
+ * Prototype of a native implementation of a kernel. Each call processes the
+ * part of the index space delimited by @global_work_offset and
+ * @global_work_size. Dimensions beyond the work dimension of the kernel have
+ * an offset of 0 and a size of 1. Calls for different parts of the same
+ * execution happen concurrently, from several host threads.
+ *
+ * The arguments of the kernel are retrieved with
+ * gocl_kernel_get_argument_value().
+ **/
+
 #include <string.h>
 #include <gio/gio.h>
 
 #include "gocl-kernel.h"
 
 #include "gocl-private.h"
+#include "gocl-error.h"
 #include "gocl-program.h"
 
 typedef gsize WorkSize[3];
 
+/* values up to this size are stored without a separate allocation */
+#define ARG_INLINE_SIZE 16
+
+/* local work size tuning */
+#define TUNING_CACHE_FILE_NAME "local-work-size.ini"
+#define TUNING_RUNS 3
+#define TUNING_MAX_CANDIDATES 64
+
+/* the automatic local work size leaves at least this many work-groups per
+ * compute unit */
+#define AUTO_GROUPS_PER_UNIT 2
+
+/* native executions are split in about this many chunks per host thread */
+#define HOST_CHUNKS_PER_THREAD 4
+
+/* the last value set for a kernel argument, as passed to clSetKernelArg() */
+typedef struct
+{
+  gboolean set;
+  gsize size;
+  gboolean has_value;
+  gpointer heap_value;
+  guint8 inline_value[ARG_INLINE_SIZE];
+  GoclBuffer *buffer;
+} KernelArg;
+
+/* work-group limits of the kernel on a device, as reported by
+ * clGetKernelWorkGroupInfo(), together with the work-item limits of the
+ * device */
+typedef struct
+{
+  gsize work_group_size;
+  gsize preferred_multiple;
+  cl_ulong local_mem_size;
+  cl_ulong private_mem_size;
+  WorkSize max_work_item_sizes;
+} WorkGroupInfo;
+
+/* metadata of a kernel argument, as reported by clGetKernelArgInfo() */
+typedef struct
+{
+  gchar *name;
+  gchar *type_name;
+  cl_kernel_arg_address_qualifier address;
+} ArgInfo;
+
 struct _GoclKernelPrivate
 {
   cl_kernel kernel;
@@ -70,11 +137,102 @@ struct _GoclKernelPrivate
 
   GoclProgram *program;
 
+  WorkSize global_work_offset;
   WorkSize global_work_size;
   WorkSize local_work_size;
   guint8 work_dim;
+
+  GArray *args;
+
+  GMutex arg_info_mutex;
+  gboolean arg_info_loaded;
+  cl_int arg_info_error;
+  ArgInfo *arg_info;
+  guint n_args;
+  GHashTable *arg_index;
+
+  gboolean autotune;
+  GoclDevice *tuned_device;
+  WorkSize tuned_size_class;
+  gboolean tuned_found;
+  WorkSize tuned_local_work_size;
+
+  GoclNativeKernelFunc native_func;
+  gpointer native_data;
+
+  GMutex work_group_info_mutex;
+  GHashTable *work_group_info;
+
+  gboolean auto_local_size;
+  cl_device_id auto_device_id;
+  guint8 auto_work_dim;
+  WorkSize auto_global_work_size;
+  WorkSize auto_local_work_size;
+
+  GPtrArray *split_devices;
+  GMutex throughput_mutex;
+  GHashTable *throughput;
 };
 
+/* the index space of one enqueued execution, which may be a part of the
+ * configured one, and the local work size actually used for it */
+typedef struct
+{
+  GoclKernel *kernel;
+  WorkSize offset;
+  WorkSize size;
+  WorkSize local;
+} Slice;
+
+/* the part of a split execution that runs on one device */
+typedef struct
+{
+  GoclKernel *kernel;
+  cl_device_id device_id;
+  gsize work_items;
+  gint64 start_time;
+} SplitPart;
+
+/* an execution of a native kernel on host threads */
+typedef struct
+{
+  GoclKernel *kernel;
+  GoclEvent *event;
+  GoclEventResolverFunc resolver_func;
+
+  WorkSize offset;
+  WorkSize size;
+  gsize chunk_size;
+  gint n_chunks;
+  gint next_chunk;
+
+  guint n_workers;
+  gint active_workers;
+
+  gint pending_waits;
+  GError *wait_error;
+} HostRun;
+
+static GMutex host_pool_mutex;
+static GThreadPool *host_pool = NULL;
+
+/* the clone of a kernel owned by a thread */
+typedef struct
+{
+  GWeakRef kernel;
+  GoclKernel *instance;
+} ThreadInstance;
+
+/* the instances of the calling thread, indexed by kernel, released when the
+   thread exits */
+static GPrivate thread_instances =
+  G_PRIVATE_INIT ((GDestroyNotify) g_hash_table_unref);
+
+/* tuned local work sizes shared by all kernels, backed by a file */
+static GMutex tuning_cache_mutex;
+static GKeyFile *tuning_cache = NULL;
+static gchar *tuning_cache_file = NULL;
+
 /* properties */
 enum
 {
@@ -91,6 +249,11 @@ static gboolean       gocl_kernel_initable_init         (GInitable     *initable
 static void           gocl_kernel_init                  (GoclKernel *self);
 static void           gocl_kernel_finalize              (GObject *obj);
 
+static void           clear_arg                         (gpointer data);
+static void           prepare_local_work_size           (GoclKernel *self,
+                                                         GoclQueue  *queue,
+                                                         WorkSize    local_work_size);
+
 static void           set_property                       (GObject      *obj,
                                                           guint         prop_id,
                                                           const GValue *value,
@@ -154,6 +317,25 @@ gocl_kernel_initable_init (GInitable     *initable,
 
   program = gocl_program_get_program (self->priv->program);
 
+  if (program == NULL)
+    {
+      self->priv->native_func =
+        gocl_program_get_native_kernel (self->priv->program,
+                                        self->priv->name,
+                                        &self->priv->native_data);
+      if (self->priv->native_func == NULL)
+        {
+          g_set_error (error,
+                       GOCL_OPENCL_ERROR,
+                       CL_INVALID_KERNEL_NAME,
+                       "Native program has no kernel '%s'",
+                       self->priv->name);
+          return FALSE;
+        }
+
+      return TRUE;
+    }
+
   self->priv->kernel = clCreateKernel (program, self->priv->name, &err_code);
   if (gocl_error_check_opencl (err_code, error))
     return FALSE;
@@ -169,8 +351,32 @@ gocl_kernel_init (GoclKernel *self)
   self->priv = priv = GOCL_KERNEL_GET_PRIVATE (self);
 
   priv->work_dim = 1;
-  memset (&priv->global_work_size, 0, 3);
-  memset (&priv->local_work_size, 0, 3);
+  memset (&priv->global_work_offset, 0, sizeof (WorkSize));
+  memset (&priv->global_work_size, 0, sizeof (WorkSize));
+  memset (&priv->local_work_size, 0, sizeof (WorkSize));
+
+  priv->args = g_array_new (FALSE, TRUE, sizeof (KernelArg));
+  g_array_set_clear_func (priv->args, clear_arg);
+
+  g_mutex_init (&priv->arg_info_mutex);
+  priv->arg_info_loaded = FALSE;
+  priv->arg_info = NULL;
+  priv->n_args = 0;
+  priv->arg_index = NULL;
+
+  priv->autotune = FALSE;
+  priv->tuned_device = NULL;
+  priv->tuned_found = FALSE;
+
+  g_mutex_init (&priv->work_group_info_mutex);
+  priv->work_group_info = NULL;
+
+  priv->auto_local_size = FALSE;
+  priv->auto_device_id = NULL;
+
+  priv->split_devices = NULL;
+  g_mutex_init (&priv->throughput_mutex);
+  priv->throughput = NULL;
 }
 
 static void
@@ -180,9 +386,43 @@ gocl_kernel_finalize (GObject *obj)
 
   g_free (self->priv->name);
 
+  g_array_unref (self->priv->args);
+
+  if (self->priv->arg_info != NULL)
+    {
+      guint i;
+
+      for (i = 0; i < self->priv->n_args; i++)
+        {
+          g_free (self->priv->arg_info[i].name);
+          g_free (self->priv->arg_info[i].type_name);
+        }
+      g_free (self->priv->arg_info);
+    }
+
+  if (self->priv->arg_index != NULL)
+    g_hash_table_unref (self->priv->arg_index);
+
+  g_mutex_clear (&self->priv->arg_info_mutex);
+
+  if (self->priv->tuned_device != NULL)
+    g_object_unref (self->priv->tuned_device);
+
+  if (self->priv->work_group_info != NULL)
+    g_hash_table_unref (self->priv->work_group_info);
+  g_mutex_clear (&self->priv->work_group_info_mutex);
+
+  if (self->priv->split_devices != NULL)
+    g_ptr_array_unref (self->priv->split_devices);
+
+  if (self->priv->throughput != NULL)
+    g_hash_table_unref (self->priv->throughput);
+  g_mutex_clear (&self->priv->throughput_mutex);
+
   g_object_unref (self->priv->program);
 
-  clReleaseKernel (self->priv->kernel);
+  if (self->priv->kernel != NULL)
+    clReleaseKernel (self->priv->kernel);
 
   G_OBJECT_CLASS (gocl_kernel_parent_class)->finalize (obj);
 }
@@ -239,347 +479,3542 @@ get_property (GObject    *obj,
     }
 }
 
-/* public */
+static cl_int
+enqueue_nd_range (GoclKernel        *self,
+                  cl_command_queue   queue,
+                  const gsize       *global_work_offset,
+                  const gsize       *global_work_size,
+                  const gsize       *local_work_size,
+                  guint              event_wait_list_len,
+                  const cl_event    *event_wait_list,
+                  cl_event          *out_event)
+{
+  gboolean has_offset;
 
-/**
- * gocl_kernel_get_kernel:
- * @self: The #GoclKernel
- *
- * Retrieves the internal OpenCL #cl_kernel object. This is not normally
- * called by applications. It is rather a low-level, internal API.
- *
- * Returns: (transfer none) (type guint64): The internal #cl_kernel object
- **/
-cl_kernel
-gocl_kernel_get_kernel (GoclKernel *self)
+  has_offset = global_work_offset[0] != 0 ||
+    global_work_offset[1] != 0 ||
+    global_work_offset[2] != 0;
+
+  return
+    clEnqueueNDRangeKernel (queue,
+                            self->priv->kernel,
+                            self->priv->work_dim,
+                            has_offset ? global_work_offset : NULL,
+                            global_work_size[0] == 0 ?
+                              NULL : global_work_size,
+                            local_work_size[0] == 0 ?
+                              NULL : local_work_size,
+                            event_wait_list_len,
+                            event_wait_list,
+                            out_event);
+}
+
+static cl_int
+enqueue_slice (cl_command_queue  queue,
+               guint             event_wait_list_len,
+               const cl_event   *event_wait_list,
+               cl_event         *out_event,
+               gpointer          user_data)
 {
-  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+  Slice *slice = user_data;
+
+  return enqueue_nd_range (slice->kernel,
+                           queue,
+                           slice->offset,
+                           slice->size,
+                           slice->local,
+                           event_wait_list_len,
+                           event_wait_list,
+                           out_event);
+}
 
-  return self->priv->kernel;
+static cl_int
+enqueue_marker (cl_command_queue  queue,
+                guint             event_wait_list_len,
+                const cl_event   *event_wait_list,
+                cl_event         *out_event,
+                gpointer          user_data)
+{
+  return clEnqueueMarkerWithWaitList (queue,
+                                      event_wait_list_len,
+                                      event_wait_list,
+                                      out_event);
 }
 
-/**
- * gocl_kernel_set_argument:
- * @self: The #GoclKernel
- * @index: The index of this argument in the kernel function
- * @size: The size of @buffer, in bytes
- * @buffer: A pointer to an arbitrary block of memory
- *
- * Sets the value of the kernel argument at @index, as an arbitrary block of
- * memory.
- *
- * Returns: %TRUE on success, %FALSE on error
- **/
-gboolean
-gocl_kernel_set_argument (GoclKernel      *self,
-                          guint            index,
-                          gsize            size,
-                          const gpointer  *buffer)
+static void
+clear_arg (gpointer data)
 {
-  cl_int err_code;
+  KernelArg *arg = data;
 
-  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_free (arg->heap_value);
+  arg->heap_value = NULL;
 
-  err_code = clSetKernelArg (self->priv->kernel,
-                             index,
-                             size,
-                             buffer);
+  if (arg->buffer != NULL)
+    {
+      g_object_unref (arg->buffer);
+      arg->buffer = NULL;
+    }
 
-  return ! gocl_error_check_opencl_internal (err_code);
+  arg->set = FALSE;
 }
 
-/**
- * gocl_kernel_set_argument_int32:
- * @self: The #GoclKernel
- * @index: The index of this argument in the kernel function
- * @num_elements: The number of int32 elements in @buffer
- * @buffer: (array length=num_elements) (element-type guint32): Array of int32
- * values
- *
- * Sets the value of the kernel argument at @index, as an array of int32.
- *
- * Returns: %TRUE on success, %FALSE on error
- **/
-gboolean
-gocl_kernel_set_argument_int32 (GoclKernel  *self,
-                                guint        index,
-                                gsize        num_elements,
-                                gint32      *buffer)
+static gconstpointer
+get_arg_value (const KernelArg *arg)
 {
-  return gocl_kernel_set_argument (self,
-                                   index,
-                                   sizeof (cl_uint) * num_elements,
-                                   (const gpointer) buffer);
+  if (! arg->has_value)
+    return NULL;
+  else if (arg->size <= ARG_INLINE_SIZE)
+    return arg->inline_value;
+  else
+    return arg->heap_value;
 }
 
-/**
- * gocl_kernel_set_argument_float:
- * @self: The #GoclKernel
- * @index: The index of this argument in the kernel function
- * @num_elements: The number of float elements in @buffer
- * @buffer: (array length=num_elements) (element-type gfloat): Array of float
- * values
- *
- * Sets the value of the kernel argument at @index, as an array of floats.
- *
- * Returns: %TRUE on success, %FALSE on error
- **/
-gboolean
-gocl_kernel_set_argument_float (GoclKernel  *self,
-                                guint        index,
-                                gsize        num_elements,
-                                gfloat      *buffer)
+static void
+store_arg (GoclKernel     *self,
+           guint           index,
+           gsize           size,
+           gconstpointer   value,
+           GoclBuffer     *buffer)
 {
-  return gocl_kernel_set_argument (self,
-                                   index,
-                                   sizeof (cl_float) * num_elements,
-                                   (const gpointer) buffer);
-}
+  KernelArg *arg;
 
-/**
- * gocl_kernel_set_argument_buffer:
- * @self: The #GoclKernel
- * @index: The index of this argument in the kernel function
- * @buffer: A #GoclBuffer
- *
- * Sets the value of the kernel argument at @index, as a buffer object.
- *
- * Returns: %TRUE on success, %FALSE on error
- **/
-gboolean
-gocl_kernel_set_argument_buffer (GoclKernel  *self,
-                                 guint        index,
-                                 GoclBuffer  *buffer)
-{
-  cl_int err_code;
-  cl_mem buf;
+  if (index >= self->priv->args->len)
+    g_array_set_size (self->priv->args, index + 1);
 
-  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  arg = &g_array_index (self->priv->args, KernelArg, index);
+  clear_arg (arg);
 
-  buf = gocl_buffer_get_buffer (buffer);
+  arg->set = TRUE;
+  arg->size = size;
+  arg->has_value = value != NULL;
 
-  err_code = clSetKernelArg (self->priv->kernel,
-                             index,
-                             sizeof (cl_mem),
-                             &buf);
+  if (value != NULL)
+    {
+      if (size <= ARG_INLINE_SIZE)
+        memcpy (arg->inline_value, value, size);
+      else
+        arg->heap_value = g_memdup (value, size);
+    }
 
-  return ! gocl_error_check_opencl_internal (err_code);
+  if (buffer != NULL)
+    arg->buffer = g_object_ref (buffer);
 }
 
-/**
- * gocl_kernel_run_in_device_sync:
- * @self: The #GoclKernel
- * @device: A #GoclDevice to run the kernel on
- * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
- * events to wait for, or %NULL
- *
- * Runs the kernel on the specified device, blocking the program
- * until the kernel execution finishes. For non-blocking version,
- * gocl_kernel_run_in_device() is provided.
- *
- * If @event_wait_list is provided, the kernel execution will start
- * only when all the events in the list have triggered.
- *
- * Returns: %TRUE on success, %FALSE on error
- **/
-gboolean
-gocl_kernel_run_in_device_sync (GoclKernel  *self,
-                                GoclDevice  *device,
-                                GList       *event_wait_list)
+/* whether clSetKernelArg() was already called with exactly these values */
+static gboolean
+arg_unchanged (GoclKernel     *self,
+               guint           index,
+               gsize           size,
+               gconstpointer   value,
+               GoclBuffer     *buffer)
 {
-  cl_int err_code;
-  cl_event event;
-  GoclQueue *queue;
-  cl_command_queue _queue;
-  cl_event *_event_wait_list = NULL;
+  const KernelArg *arg;
 
-  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
-  g_return_val_if_fail (GOCL_IS_DEVICE (device), FALSE);
+  if (index >= self->priv->args->len)
+    return FALSE;
 
-  queue = gocl_device_get_default_queue (device);
-  if (queue == NULL)
+  arg = &g_array_index (self->priv->args, KernelArg, index);
+
+  if (! arg->set || arg->size != size || arg->buffer != buffer)
     return FALSE;
 
-  _event_wait_list = gocl_event_list_to_array (event_wait_list, NULL);
+  if (! arg->has_value || value == NULL)
+    return ! arg->has_value && value == NULL;
 
-  _queue = gocl_queue_get_queue (queue);
+  return memcmp (get_arg_value (arg), value, size) == 0;
+}
 
-  err_code =
-    clEnqueueNDRangeKernel (_queue,
-                            self->priv->kernel,
-                            self->priv->work_dim,
-                            NULL,
-                            self->priv->global_work_size[0] == 0 ?
-                              NULL : (gsize *) &self->priv->global_work_size,
-                            self->priv->local_work_size[0] == 0 ?
-                              NULL : (gsize *) &self->priv->local_work_size,
-                            g_list_length (event_wait_list),
-                            _event_wait_list,
-                            &event);
-  g_free (_event_wait_list);
+static gboolean
+set_arg (GoclKernel     *self,
+         guint           index,
+         gsize           size,
+         gconstpointer   value,
+         GoclBuffer     *buffer)
+{
+  cl_int err_code;
 
-  if (gocl_error_check_opencl_internal (err_code))
-    return FALSE;
+  if (arg_unchanged (self, index, size, value, buffer))
+    return TRUE;
 
-  clWaitForEvents (1, &event);
-  clReleaseEvent (event);
+  /* native kernels only read the stored values */
+  if (self->priv->kernel != NULL)
+    {
+      err_code = clSetKernelArg (self->priv->kernel, index, size, value);
+      if (gocl_error_check_opencl_internal (err_code))
+        return FALSE;
+    }
+
+  store_arg (self, index, size, value, buffer);
 
   return TRUE;
 }
 
-/**
- * gocl_kernel_run_in_device:
- * @self: The #GoclKernel
- * @device: A #GoclDevice to run the kernel on
- * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
- * events to wait for, or %NULL
- *
- * Runs the kernel on the specified device, asynchronously. A #GoclEvent
- * is returned, and can be used to get notified when the execution finishes,
- * or as wait event input to other operations on the device.
- *
- * If @event_wait_list is provided, the kernel execution will start
- * only when all the events in the list have triggered.
- *
- * Returns: (transfer none): A #GoclEvent to get notified when execution
- * finishes
- **/
-GoclEvent *
-gocl_kernel_run_in_device (GoclKernel *self,
-                           GoclDevice *device,
-                           GList      *event_wait_list)
+static gchar *
+query_arg_string (cl_kernel kernel, guint index, cl_kernel_arg_info param,
+                  cl_int *err_code)
 {
-  GError *error = NULL;
+  gsize size;
+  gchar *str;
 
-  cl_int err_code;
-  cl_event event;
-  GoclQueue *queue = NULL;
-  cl_command_queue _queue;
+  *err_code = clGetKernelArgInfo (kernel, index, param, 0, NULL, &size);
+  if (*err_code != CL_SUCCESS)
+    return NULL;
 
-  GoclEvent *_event = NULL;
-  GoclEventResolverFunc resolver_func;
+  str = g_malloc0 (size + 1);
+  *err_code = clGetKernelArgInfo (kernel, index, param, size, str, NULL);
+  if (*err_code != CL_SUCCESS)
+    {
+      g_free (str);
+      return NULL;
+    }
 
-  cl_event *_event_wait_list = NULL;
-  guint event_wait_list_len;
+  return str;
+}
 
-  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
-  g_return_val_if_fail (GOCL_IS_DEVICE (device), FALSE);
+/* queries the metadata of all the arguments, only the first time it is
+   called; the result is kept even if the query fails */
+static gboolean
+load_arg_info (GoclKernel *self)
+{
+  GoclKernelPrivate *priv = self->priv;
+  cl_uint n_args;
+  cl_int err_code;
+  guint i;
 
-  _event_wait_list = gocl_event_list_to_array (event_wait_list,
-                                               &event_wait_list_len);
+  g_mutex_lock (&priv->arg_info_mutex);
 
-  queue = gocl_device_get_default_queue (device);
-  if (queue == NULL)
+  if (priv->arg_info_loaded)
     goto out;
 
-  _queue = gocl_queue_get_queue (queue);
+  priv->arg_info_loaded = TRUE;
 
-  err_code =
-    clEnqueueNDRangeKernel (_queue,
-                            self->priv->kernel,
-                            self->priv->work_dim,
-                            NULL,
-                            self->priv->global_work_size[0] == 0 ?
-                              NULL : (gsize *) &self->priv->global_work_size,
-                            self->priv->local_work_size[0] == 0 ?
-                              NULL : (gsize *) &self->priv->local_work_size,
-                            event_wait_list_len,
-                            _event_wait_list,
-                            &event);
-  g_free (_event_wait_list);
+  err_code = clGetKernelInfo (priv->kernel,
+                              CL_KERNEL_NUM_ARGS,
+                              sizeof (cl_uint),
+                              &n_args,
+                              NULL);
+  if (err_code != CL_SUCCESS)
+    goto done;
 
-  if (! gocl_error_check_opencl (err_code, &error))
+  priv->arg_info = g_new0 (ArgInfo, n_args);
+  priv->n_args = n_args;
+  priv->arg_index = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i < n_args && err_code == CL_SUCCESS; i++)
     {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             "event", event,
-                             NULL);
-      gocl_event_set_event_wait_list (_event, event_wait_list);
-      gocl_event_steal_resolver_func (_event);
+      ArgInfo *info = &priv->arg_info[i];
+
+      info->name = query_arg_string (priv->kernel, i, CL_KERNEL_ARG_NAME,
+                                     &err_code);
+      if (err_code != CL_SUCCESS)
+        break;
+
+      info->type_name = query_arg_string (priv->kernel, i,
+                                          CL_KERNEL_ARG_TYPE_NAME,
+                                          &err_code);
+      if (err_code != CL_SUCCESS)
+        break;
+
+      err_code = clGetKernelArgInfo (priv->kernel,
+                                     i,
+                                     CL_KERNEL_ARG_ADDRESS_QUALIFIER,
+                                     sizeof (cl_kernel_arg_address_qualifier),
+                                     &info->address,
+                                     NULL);
+
+      g_hash_table_insert (priv->arg_index,
+                           info->name,
+                           GUINT_TO_POINTER (i + 1));
     }
 
+ done:
+  priv->arg_info_error = err_code;
+
  out:
-  if (error != NULL)
-    {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
+  err_code = priv->arg_info_error;
+  g_mutex_unlock (&priv->arg_info_mutex);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
+static const ArgInfo *
+lookup_arg_info (GoclKernel *self, const gchar *name, guint *index)
+{
+  gpointer value;
+
+  if (! load_arg_info (self))
+    return NULL;
+
+  value = g_hash_table_lookup (self->priv->arg_index, name);
+  if (value == NULL)
+    {
+      g_set_error (gocl_error_prepare (),
+                   GOCL_OPENCL_ERROR,
+                   CL_INVALID_ARG_INDEX,
+                   "Kernel '%s' has no argument named '%s'",
+                   self->priv->name,
+                   name);
+      return NULL;
+    }
+
+  *index = GPOINTER_TO_UINT (value) - 1;
+
+  return &self->priv->arg_info[*index];
+}
+
+/* returns the size of a scalar or vector type, or 0 if unknown */
+static gsize
+get_type_size (const gchar *type_name)
+{
+  static const struct
+  {
+    const gchar *name;
+    gsize size;
+  } types[] = {
+    { "uchar", 1 }, { "char", 1 },
+    { "ushort", 2 }, { "short", 2 }, { "half", 2 },
+    { "uint", 4 }, { "int", 4 }, { "float", 4 },
+    { "ulong", 8 }, { "long", 8 }, { "double", 8 }
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (types); i++)
+    {
+      gsize len = strlen (types[i].name);
+      guint64 width;
+      gchar *end;
+
+      if (strncmp (type_name, types[i].name, len) != 0)
+        continue;
+
+      if (type_name[len] == '\0')
+        return types[i].size;
+
+      width = g_ascii_strtoull (type_name + len, &end, 10);
+      if (*end != '\0')
+        return 0;
+
+      /* 3-component vectors are stored as 4-component ones */
+      if (width == 3)
+        width = 4;
+
+      if (width == 2 || width == 4 || width == 8 || width == 16)
+        return types[i].size * width;
+
+      return 0;
+    }
+
+  return 0;
+}
+
+/* whether @type_name is @base, or a vector of @base */
+static gboolean
+is_type_or_vector_of (const gchar *type_name, const gchar *base)
+{
+  const gchar *p;
+
+  if (base == NULL || ! g_str_has_prefix (type_name, base))
+    return FALSE;
+
+  for (p = type_name + strlen (base); *p != '\0'; p++)
+    if (! g_ascii_isdigit (*p))
+      return FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+check_type_name (GoclKernel    *self,
+                 const ArgInfo *info,
+                 const gchar   *base1,
+                 const gchar   *base2)
+{
+  if (info->address == CL_KERNEL_ARG_ADDRESS_PRIVATE &&
+      (is_type_or_vector_of (info->type_name, base1) ||
+       is_type_or_vector_of (info->type_name, base2)))
+    {
+      return TRUE;
+    }
+
+  g_set_error (gocl_error_prepare (),
+               GOCL_OPENCL_ERROR,
+               CL_INVALID_ARG_VALUE,
+               "Argument '%s' of kernel '%s' has type '%s', not '%s'",
+               info->name,
+               self->priv->name,
+               info->type_name,
+               base1);
+
+  return FALSE;
+}
+
+static gboolean
+check_arg_value (GoclKernel    *self,
+                 const ArgInfo *info,
+                 gsize          size,
+                 gconstpointer  value)
+{
+  gsize expected_size = 0;
+
+  switch (info->address)
+    {
+    case CL_KERNEL_ARG_ADDRESS_LOCAL:
+      if (value != NULL)
+        {
+          g_set_error (gocl_error_prepare (),
+                       GOCL_OPENCL_ERROR,
+                       CL_INVALID_ARG_VALUE,
+                       "Argument '%s' of kernel '%s' is in local memory, "
+                       "only its size can be set",
+                       info->name,
+                       self->priv->name);
+          return FALSE;
+        }
+      return TRUE;
+
+    case CL_KERNEL_ARG_ADDRESS_GLOBAL:
+    case CL_KERNEL_ARG_ADDRESS_CONSTANT:
+      expected_size = sizeof (cl_mem);
+      break;
+
+    default:
+      expected_size = get_type_size (info->type_name);
+      break;
+    }
+
+  if (expected_size != 0 && size != expected_size)
+    {
+      g_set_error (gocl_error_prepare (),
+                   GOCL_OPENCL_ERROR,
+                   CL_INVALID_ARG_SIZE,
+                   "Argument '%s' of kernel '%s' has type '%s' of size %"
+                   G_GSIZE_FORMAT ", but a value of size %" G_GSIZE_FORMAT
+                   " was given",
+                   info->name,
+                   self->priv->name,
+                   info->type_name,
+                   expected_size,
+                   size);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* fills @accesses, which must hold at least args->len elements */
+static guint
+get_buffer_accesses (GoclKernel *self, GoclBufferAccess *accesses)
+{
+  guint i;
+  guint n_accesses = 0;
+
+  for (i = 0; i < self->priv->args->len; i++)
+    {
+      GoclBuffer *buffer;
+
+      buffer = g_array_index (self->priv->args, KernelArg, i).buffer;
+      if (buffer == NULL)
+        continue;
+
+      accesses[n_accesses].buffer = buffer;
+      accesses[n_accesses].write =
+        (gocl_buffer_get_flags (buffer) & GOCL_BUFFER_FLAGS_READ_ONLY) == 0;
+      accesses[n_accesses].transfer_size = 0;
+      n_accesses++;
+    }
+
+  return n_accesses;
+}
+
+/* the returned info is owned by the kernel, and never changes */
+static const WorkGroupInfo *
+get_work_group_info (GoclKernel *self, GoclDevice *device)
+{
+  GoclKernelPrivate *priv = self->priv;
+  cl_device_id device_id;
+  WorkGroupInfo *info;
+  cl_int err_code;
+  gsize len;
+  guint i;
+
+  device_id = gocl_device_get_id (device);
+
+  g_mutex_lock (&priv->work_group_info_mutex);
+
+  if (priv->work_group_info == NULL)
+    priv->work_group_info = g_hash_table_new_full (g_direct_hash,
+                                                   g_direct_equal,
+                                                   NULL,
+                                                   g_free);
+
+  info = g_hash_table_lookup (priv->work_group_info, device_id);
+  if (info != NULL)
+    goto out;
+
+  info = g_new0 (WorkGroupInfo, 1);
+
+  err_code = clGetKernelWorkGroupInfo (priv->kernel,
+                                       device_id,
+                                       CL_KERNEL_WORK_GROUP_SIZE,
+                                       sizeof (gsize),
+                                       &info->work_group_size,
+                                       NULL);
+  if (gocl_error_check_opencl_internal (err_code))
+    {
+      g_free (info);
+      info = NULL;
+      goto out;
+    }
+
+  /* the rest of the keys are optional, or not available in OpenCL 1.0 */
+  if (clGetKernelWorkGroupInfo (priv->kernel,
+                                device_id,
+                                CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE,
+                                sizeof (gsize),
+                                &info->preferred_multiple,
+                                NULL) != CL_SUCCESS ||
+      info->preferred_multiple == 0)
+    {
+      info->preferred_multiple = 1;
+    }
+
+  clGetKernelWorkGroupInfo (priv->kernel,
+                            device_id,
+                            CL_KERNEL_LOCAL_MEM_SIZE,
+                            sizeof (cl_ulong),
+                            &info->local_mem_size,
+                            NULL);
+  clGetKernelWorkGroupInfo (priv->kernel,
+                            device_id,
+                            CL_KERNEL_PRIVATE_MEM_SIZE,
+                            sizeof (cl_ulong),
+                            &info->private_mem_size,
+                            NULL);
+
+  for (i = 0; i < 3; i++)
+    info->max_work_item_sizes[i] = info->work_group_size;
+  if (clGetDeviceInfo (device_id,
+                       CL_DEVICE_MAX_WORK_ITEM_SIZES,
+                       0,
+                       NULL,
+                       &len) == CL_SUCCESS &&
+      len >= sizeof (WorkSize))
+    {
+      gsize *item_sizes;
+
+      item_sizes = g_malloc (len);
+      if (clGetDeviceInfo (device_id,
+                           CL_DEVICE_MAX_WORK_ITEM_SIZES,
+                           len,
+                           item_sizes,
+                           NULL) == CL_SUCCESS)
+        {
+          memcpy (info->max_work_item_sizes, item_sizes, sizeof (WorkSize));
+        }
+      g_free (item_sizes);
+    }
+
+  g_hash_table_insert (priv->work_group_info, device_id, info);
+
+ out:
+  g_mutex_unlock (&priv->work_group_info_mutex);
+
+  return info;
+}
+
+/* the maximum work-group size of the kernel on @device */
+static gsize
+get_max_group_size (const WorkGroupInfo *info, GoclDevice *device)
+{
+  gsize device_max;
+
+  device_max = gocl_device_get_max_work_group_size (device);
+  if (device_max == 0)
+    return info->work_group_size;
+
+  return MIN (info->work_group_size, device_max);
+}
+
+static gsize
+round_up_pow2 (gsize value)
+{
+  gsize result = 1;
+
+  while (result < value)
+    result <<= 1;
+
+  return result;
+}
+
+/* global work sizes are grouped by the next power of two of each dimension */
+static void
+get_size_class (GoclKernel *self, WorkSize size_class)
+{
+  guint i;
+
+  for (i = 0; i < 3; i++)
+    size_class[i] = i < self->priv->work_dim ?
+      round_up_pow2 (self->priv->global_work_size[i]) : 1;
+}
+
+static gchar *
+query_device_string (cl_device_id device_id, cl_device_info param)
+{
+  gsize size;
+  gchar *value;
+
+  if (clGetDeviceInfo (device_id, param, 0, NULL, &size) != CL_SUCCESS)
+    return g_strdup ("");
+
+  value = g_malloc0 (size + 1);
+  clGetDeviceInfo (device_id, param, size, value, NULL);
+
+  return value;
+}
+
+/* the group identifies the kernel by its source code, and the key the device
+ * model and driver, and the global size class */
+static gchar *
+get_tuning_key (GoclKernel  *self,
+                GoclDevice  *device,
+                WorkSize     size_class,
+                gchar      **group)
+{
+  cl_device_id device_id;
+  gchar *vendor;
+  gchar *name;
+  gchar *version;
+  gchar *device_str;
+  gchar *device_hash;
+  gchar *key;
+
+  device_id = gocl_device_get_id (device);
+  vendor = query_device_string (device_id, CL_DEVICE_VENDOR);
+  name = query_device_string (device_id, CL_DEVICE_NAME);
+  version = query_device_string (device_id, CL_DRIVER_VERSION);
+
+  device_str = g_strdup_printf ("%s\n%s\n%s", vendor, name, version);
+  device_hash = g_compute_checksum_for_string (G_CHECKSUM_SHA1, device_str, -1);
+
+  *group = g_strdup_printf ("%s/%s",
+                            gocl_program_get_source_hash (self->priv->program),
+                            self->priv->name);
+  key = g_strdup_printf ("%s-%" G_GSIZE_FORMAT "x%" G_GSIZE_FORMAT
+                         "x%" G_GSIZE_FORMAT,
+                         device_hash,
+                         size_class[0],
+                         size_class[1],
+                         size_class[2]);
+
+  g_free (device_hash);
+  g_free (device_str);
+  g_free (version);
+  g_free (name);
+  g_free (vendor);
+
+  return key;
+}
+
+/* must be called with tuning_cache_mutex held */
+static GKeyFile *
+get_tuning_cache (void)
+{
+  if (tuning_cache == NULL)
+    {
+      tuning_cache = g_key_file_new ();
+      tuning_cache_file = g_build_filename (g_get_user_cache_dir (),
+                                            "gocl",
+                                            TUNING_CACHE_FILE_NAME,
+                                            NULL);
+
+      /* a missing or unreadable file just means nothing was tuned yet */
+      g_key_file_load_from_file (tuning_cache,
+                                 tuning_cache_file,
+                                 G_KEY_FILE_NONE,
+                                 NULL);
+    }
+
+  return tuning_cache;
+}
+
+static gboolean
+lookup_tuned_size (const gchar *group,
+                   const gchar *key,
+                   WorkSize     local_work_size)
+{
+  gint *values;
+  gsize len;
+  gboolean found = FALSE;
+
+  g_mutex_lock (&tuning_cache_mutex);
+
+  values = g_key_file_get_integer_list (get_tuning_cache (),
+                                        group,
+                                        key,
+                                        &len,
+                                        NULL);
+  if (values != NULL && len == 3)
+    {
+      guint i;
+
+      for (i = 0; i < 3; i++)
+        local_work_size[i] = MAX (values[i], 0);
+      found = TRUE;
+    }
+  g_free (values);
+
+  g_mutex_unlock (&tuning_cache_mutex);
+
+  return found;
+}
+
+static void
+store_tuned_size (const gchar    *group,
+                  const gchar    *key,
+                  const WorkSize  local_work_size)
+{
+  GKeyFile *cache;
+  gint values[3];
+  gchar *dir;
+  guint i;
+
+  g_mutex_lock (&tuning_cache_mutex);
+
+  cache = get_tuning_cache ();
+
+  for (i = 0; i < 3; i++)
+    values[i] = (gint) local_work_size[i];
+  g_key_file_set_integer_list (cache, group, key, values, 3);
+
+  /* the file only saves tuning on later runs, so failing to write it is not
+   * an error */
+  dir = g_path_get_dirname (tuning_cache_file);
+  if (g_mkdir_with_parents (dir, 0700) == 0)
+    {
+      gchar *data;
+      gsize len;
+
+      data = g_key_file_to_data (cache, &len, NULL);
+      g_file_set_contents (tuning_cache_file, data, len, NULL);
+      g_free (data);
+    }
+  g_free (dir);
+
+  g_mutex_unlock (&tuning_cache_mutex);
+}
+
+/* fills @candidates with the local work sizes worth measuring on @device,
+ * starting with the choice of the driver (all zeros) */
+static guint
+get_tuning_candidates (GoclKernel *self,
+                       GoclDevice *device,
+                       WorkSize   *candidates)
+{
+  GoclKernelPrivate *priv = self->priv;
+  const WorkGroupInfo *info;
+  gsize max_size;
+  gsize multiple;
+  WorkSize max_items;
+  WorkSize size;
+  guint n = 0;
+  guint i;
+
+  /* without the limits of the kernel, only the driver's choice is safe */
+  memset (candidates[n++], 0, sizeof (WorkSize));
+
+  info = get_work_group_info (self, device);
+  if (info == NULL)
+    return n;
+
+  max_size = get_max_group_size (info, device);
+
+  /* candidates are powers of two, so only a power of two multiple can be
+   * honored */
+  multiple = info->preferred_multiple;
+  if ((multiple & (multiple - 1)) != 0)
+    multiple = 1;
+
+  memcpy (max_items, info->max_work_item_sizes, sizeof (WorkSize));
+  for (i = priv->work_dim; i < 3; i++)
+    max_items[i] = 1;
+
+  for (size[0] = 1; size[0] <= max_items[0]; size[0] <<= 1)
+    for (size[1] = 1; size[1] <= max_items[1]; size[1] <<= 1)
+      for (size[2] = 1; size[2] <= max_items[2]; size[2] <<= 1)
+        {
+          gsize group_size;
+          gboolean divides = TRUE;
+
+          group_size = size[0] * size[1] * size[2];
+          if (group_size > max_size || group_size % multiple != 0)
+            continue;
+
+          for (i = 0; i < priv->work_dim; i++)
+            if (priv->global_work_size[i] % size[i] != 0)
+              divides = FALSE;
+          if (! divides)
+            continue;
+
+          if (n == TUNING_MAX_CANDIDATES)
+            return n;
+
+          memcpy (candidates[n++], size, sizeof (WorkSize));
+        }
+
+  return n;
+}
+
+/* runs the kernel with the local work size of @slice on a profiling @queue,
+ * and returns the shortest execution time in @time */
+static cl_int
+measure_local_size (GoclKernel  *self,
+                    GoclQueue   *queue,
+                    const Slice *slice,
+                    guint64     *time)
+{
+  GoclBufferAccess *accesses;
+  guint n_accesses;
+  guint i;
+
+  accesses = g_newa (GoclBufferAccess, self->priv->args->len);
+  n_accesses = get_buffer_accesses (self, accesses);
+
+  *time = G_MAXUINT64;
+
+  /* the first run is not measured, it pays for lazy allocations and caches */
+  for (i = 0; i < TUNING_RUNS + 1; i++)
+    {
+      cl_event event;
+      cl_ulong started;
+      cl_ulong ended;
+      cl_int err_code;
+
+      err_code = gocl_queue_enqueue (queue,
+                                     accesses,
+                                     n_accesses,
+                                     0,
+                                     NULL,
+                                     &event,
+                                     enqueue_slice,
+                                     (gpointer) slice);
+      if (err_code != CL_SUCCESS)
+        return err_code;
+
+      err_code = clWaitForEvents (1, &event);
+      if (err_code == CL_SUCCESS && i > 0)
+        err_code = clGetEventProfilingInfo (event,
+                                            CL_PROFILING_COMMAND_START,
+                                            sizeof (cl_ulong),
+                                            &started,
+                                            NULL);
+      if (err_code == CL_SUCCESS && i > 0)
+        err_code = clGetEventProfilingInfo (event,
+                                            CL_PROFILING_COMMAND_END,
+                                            sizeof (cl_ulong),
+                                            &ended,
+                                            NULL);
+      clReleaseEvent (event);
+
+      if (err_code != CL_SUCCESS)
+        return err_code;
+
+      if (i > 0)
+        *time = MIN (*time, ended - started);
+    }
+
+  return CL_SUCCESS;
+}
+
+static gboolean
+find_best_local_size (GoclKernel *self,
+                      GoclDevice *device,
+                      WorkSize    best)
+{
+  GoclQueue *queue;
+  WorkSize *candidates;
+  guint n_candidates;
+  Slice slice;
+  guint64 best_time = G_MAXUINT64;
+  cl_int err_code = CL_SUCCESS;
+  guint i;
+
+  queue = g_initable_new (GOCL_TYPE_QUEUE,
+                          NULL,
+                          gocl_error_prepare (),
+                          "device", device,
+                          "flags", GOCL_QUEUE_FLAGS_PROFILING,
+                          NULL);
+  if (queue == NULL)
+    return FALSE;
+
+  candidates = g_new (WorkSize, TUNING_MAX_CANDIDATES);
+  n_candidates = get_tuning_candidates (self, device, candidates);
+
+  slice.kernel = self;
+  memcpy (slice.offset, self->priv->global_work_offset, sizeof (WorkSize));
+  memcpy (slice.size, self->priv->global_work_size, sizeof (WorkSize));
+
+  for (i = 0; i < n_candidates; i++)
+    {
+      guint64 time;
+      cl_int candidate_err;
+
+      memcpy (slice.local, candidates[i], sizeof (WorkSize));
+
+      /* sizes the kernel cannot run with, for example because of its local
+       * memory usage, are just skipped */
+      candidate_err = measure_local_size (self, queue, &slice, &time);
+      if (candidate_err != CL_SUCCESS)
+        {
+          if (err_code == CL_SUCCESS)
+            err_code = candidate_err;
+          continue;
+        }
+
+      if (time < best_time)
+        {
+          best_time = time;
+          memcpy (best, candidates[i], sizeof (WorkSize));
+        }
+    }
+
+  g_free (candidates);
+  g_object_unref (queue);
+
+  if (best_time == G_MAXUINT64)
+    {
+      gocl_error_check_opencl_internal (err_code);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* a tuned size may not divide a global size of the same class, in which case
+ * it cannot be used */
+static gboolean
+apply_tuned_size (GoclKernel     *self,
+                  const WorkSize  tuned_size,
+                  WorkSize        local_work_size)
+{
+  guint i;
+
+  /* the choice of the driver was the fastest */
+  if (tuned_size[0] == 0)
+    {
+      memset (local_work_size, 0, sizeof (WorkSize));
+      return TRUE;
+    }
+
+  for (i = 0; i < self->priv->work_dim; i++)
+    if (tuned_size[i] == 0 ||
+        self->priv->global_work_size[i] % tuned_size[i] != 0)
+      return FALSE;
+
+  memcpy (local_work_size, tuned_size, sizeof (WorkSize));
+
+  return TRUE;
+}
+
+/* looks up the size tuned for the device of @queue and the current size class,
+ * without measuring anything, since that would run the kernel outside the
+ * order of the commands of the application */
+static gboolean
+get_tuned_size (GoclKernel *self, GoclQueue *queue, WorkSize local_work_size)
+{
+  GoclKernelPrivate *priv = self->priv;
+  GoclDevice *device;
+  WorkSize size_class;
+
+  if (priv->global_work_size[0] == 0)
+    return FALSE;
+
+  device = gocl_queue_get_device (queue);
+  get_size_class (self, size_class);
+
+  /* the cache is only looked up once per device and size class */
+  if (device != priv->tuned_device ||
+      memcmp (size_class, priv->tuned_size_class, sizeof (WorkSize)) != 0)
+    {
+      gchar *group;
+      gchar *key;
+
+      key = get_tuning_key (self, device, size_class, &group);
+      priv->tuned_found = lookup_tuned_size (group,
+                                             key,
+                                             priv->tuned_local_work_size);
+      g_free (key);
+      g_free (group);
+
+      g_object_ref (device);
+      if (priv->tuned_device != NULL)
+        g_object_unref (priv->tuned_device);
+      priv->tuned_device = device;
+      memcpy (priv->tuned_size_class, size_class, sizeof (WorkSize));
+    }
+
+  if (! priv->tuned_found)
+    return FALSE;
+
+  return apply_tuned_size (self, priv->tuned_local_work_size, local_work_size);
+}
+
+/* the largest divisor of @value not above @limit that is a multiple of
+ * @multiple, or just the largest divisor if there is none */
+static gsize
+largest_divisor (gsize value, gsize limit, gsize multiple)
+{
+  gsize d;
+
+  for (d = limit; d >= multiple && d > 1; d--)
+    if (value % d == 0 && d % multiple == 0)
+      return d;
+
+  for (d = limit; d > 1; d--)
+    if (value % d == 0)
+      return d;
+
+  return 1;
+}
+
+/* picks a legal local work size that leaves enough work-groups to keep all
+ * the compute units busy, with groups as square as possible, but at least as
+ * wide as the preferred multiple in the first dimension, which is usually the
+ * one with contiguous memory accesses */
+static void
+choose_local_size (GoclKernel          *self,
+                   GoclDevice          *device,
+                   const WorkGroupInfo *info,
+                   WorkSize             local_work_size)
+{
+  GoclKernelPrivate *priv = self->priv;
+  gsize target;
+  gsize total = 1;
+  gsize groups;
+  gsize side = 1;
+  gsize side_pow = 1;
+  guint units;
+  guint i;
+
+  for (i = 0; i < priv->work_dim; i++)
+    total *= priv->global_work_size[i];
+
+  target = get_max_group_size (info, device);
+
+  units = gocl_device_get_max_compute_units (device);
+  groups = (gsize) units * AUTO_GROUPS_PER_UNIT;
+  if (groups > 0 && total / groups < target)
+    target = MAX (total / groups, MIN (info->preferred_multiple, target));
+  target = MAX (target, 1);
+
+  /* the side of a square (or cube) group of about 'target' work-items */
+  while (side_pow < target)
+    {
+      side <<= 1;
+      side_pow = side;
+      for (i = 1; i < priv->work_dim; i++)
+        side_pow *= side;
+    }
+
+  for (i = 0; i < 3; i++)
+    local_work_size[i] = 1;
+
+  for (i = 0; i < priv->work_dim; i++)
+    {
+      gsize limit;
+      gsize multiple = 1;
+
+      limit = MIN (target, info->max_work_item_sizes[i]);
+
+      /* the last dimension takes whatever is left */
+      if (i < priv->work_dim - 1U)
+        limit = MIN (limit, i == 0 ? MAX (side, info->preferred_multiple) :
+                     side);
+
+      if (i == 0)
+        multiple = info->preferred_multiple;
+
+      local_work_size[i] = largest_divisor (priv->global_work_size[i],
+                                            MAX (limit, 1),
+                                            multiple);
+      target /= local_work_size[i];
+    }
+}
+
+/* the local work size to enqueue the kernel with on @queue, which is the
+ * configured one unless a mode that chooses it automatically is enabled */
+static void
+prepare_local_work_size (GoclKernel *self,
+                         GoclQueue  *queue,
+                         WorkSize    local_work_size)
+{
+  GoclKernelPrivate *priv = self->priv;
+  GoclDevice *device;
+  cl_device_id device_id;
+  const WorkGroupInfo *info;
+
+  if (priv->autotune && get_tuned_size (self, queue, local_work_size))
+    return;
+
+  memcpy (local_work_size, priv->local_work_size, sizeof (WorkSize));
+
+  if (! priv->auto_local_size || priv->global_work_size[0] == 0)
+    return;
+
+  device = gocl_queue_get_device (queue);
+  device_id = gocl_device_get_id (device);
+
+  /* the choice only changes with the device and the global work size */
+  if (device_id != priv->auto_device_id ||
+      priv->work_dim != priv->auto_work_dim ||
+      memcmp (priv->global_work_size,
+              priv->auto_global_work_size,
+              sizeof (WorkSize)) != 0)
+    {
+      info = get_work_group_info (self, device);
+
+      /* on error, the driver chooses */
+      if (info == NULL)
+        memset (priv->auto_local_work_size, 0, sizeof (WorkSize));
+      else
+        choose_local_size (self, device, info, priv->auto_local_work_size);
+
+      priv->auto_device_id = device_id;
+      priv->auto_work_dim = priv->work_dim;
+      memcpy (priv->auto_global_work_size,
+              priv->global_work_size,
+              sizeof (WorkSize));
+    }
+
+  memcpy (local_work_size, priv->auto_local_work_size, sizeof (WorkSize));
+}
+
+/* the whole index space of the kernel, as enqueued on @queue */
+static void
+init_slice (GoclKernel *self, GoclQueue *queue, Slice *slice)
+{
+  slice->kernel = self;
+  memcpy (slice->offset, self->priv->global_work_offset, sizeof (WorkSize));
+  memcpy (slice->size, self->priv->global_work_size, sizeof (WorkSize));
+  prepare_local_work_size (self, queue, slice->local);
+}
+
+/* the devices of the program's context, used when the application gives
+ * none, created once since each new #GoclDevice would also create a new
+ * default queue */
+static GPtrArray *
+get_split_devices (GoclKernel *self)
+{
+  GoclKernelPrivate *priv = self->priv;
+
+  if (priv->split_devices == NULL)
+    {
+      GoclContext *context;
+      guint n_devices;
+      guint i;
+
+      context = gocl_program_get_context (priv->program);
+      n_devices = gocl_context_get_num_devices (context);
+
+      priv->split_devices = g_ptr_array_new_with_free_func (g_object_unref);
+      for (i = 0; i < n_devices; i++)
+        g_ptr_array_add (priv->split_devices,
+                         gocl_context_get_device_by_index (context, i));
+    }
+
+  return priv->split_devices;
+}
+
+/* a moving average of the work-items per microsecond of the kernel on the
+ * device */
+static void
+update_throughput (GoclKernel *self, cl_device_id device_id, gdouble sample)
+{
+  GoclKernelPrivate *priv = self->priv;
+  gdouble *throughput;
+
+  g_mutex_lock (&priv->throughput_mutex);
+
+  if (priv->throughput == NULL)
+    priv->throughput = g_hash_table_new_full (g_direct_hash,
+                                              g_direct_equal,
+                                              NULL,
+                                              g_free);
+
+  throughput = g_hash_table_lookup (priv->throughput, device_id);
+  if (throughput == NULL)
+    {
+      throughput = g_new (gdouble, 1);
+      *throughput = sample;
+      g_hash_table_insert (priv->throughput, device_id, throughput);
+    }
+  else
+    {
+      *throughput = (*throughput + sample) / 2.0;
+    }
+
+  g_mutex_unlock (&priv->throughput_mutex);
+}
+
+static void
+get_split_weights (GoclKernel      *self,
+                   GPtrArray       *devices,
+                   GoclSplitPolicy  policy,
+                   gdouble         *weights)
+{
+  GoclKernelPrivate *priv = self->priv;
+  gboolean measured = FALSE;
+  guint i;
+
+  if (policy == GOCL_SPLIT_POLICY_THROUGHPUT)
+    {
+      g_mutex_lock (&priv->throughput_mutex);
+
+      measured = priv->throughput != NULL;
+      for (i = 0; i < devices->len && measured; i++)
+        {
+          gdouble *throughput;
+
+          throughput =
+            g_hash_table_lookup (priv->throughput,
+                                 gocl_device_get_id (devices->pdata[i]));
+          if (throughput == NULL || *throughput <= 0.0)
+            measured = FALSE;
+          else
+            weights[i] = *throughput;
+        }
+
+      g_mutex_unlock (&priv->throughput_mutex);
+    }
+
+  if (! measured)
+    for (i = 0; i < devices->len; i++)
+      weights[i] = MAX (gocl_device_get_max_compute_units (devices->pdata[i]),
+                        1);
+}
+
+static void
+split_part_on_complete (GoclEvent *event,
+                        GError    *error,
+                        gpointer   user_data)
+{
+  SplitPart *part = user_data;
+  GoclQueue *queue;
+  gdouble elapsed = 0.0;
+
+  /* the time spent waiting in the queue is only left out with profiling.
+     This runs on an OpenCL thread, so profiling info is only queried when
+     the queue has it, to leave the last error of that thread alone */
+  queue = gocl_event_get_queue (event);
+  if (error == NULL && queue != NULL &&
+      (gocl_queue_get_flags (queue) & GOCL_QUEUE_FLAGS_PROFILING) != 0)
+    elapsed = gocl_event_get_execution_time (event) / 1000.0;
+  if (elapsed <= 0.0)
+    elapsed = g_get_monotonic_time () - part->start_time;
+
+  if (error == NULL && elapsed > 0.0)
+    update_throughput (part->kernel,
+                       part->device_id,
+                       part->work_items / elapsed);
+
+  g_object_unref (part->kernel);
+  g_slice_free (SplitPart, part);
+}
+
+static void
+thread_instance_free (gpointer data)
+{
+  ThreadInstance *thread_instance = data;
+
+  g_weak_ref_clear (&thread_instance->kernel);
+  g_object_unref (thread_instance->instance);
+
+  g_slice_free (ThreadInstance, thread_instance);
+}
+
+/* whether the kernel an instance was cloned from is gone, in which case its
+   address may have been reused by another kernel */
+static gboolean
+thread_instance_is_stale (gpointer key, gpointer value, gpointer user_data)
+{
+  ThreadInstance *thread_instance = value;
+  GoclKernel *kernel;
+
+  kernel = g_weak_ref_get (&thread_instance->kernel);
+  if (kernel == NULL)
+    return TRUE;
+
+  g_object_unref (kernel);
+
+  return FALSE;
+}
+
+static void
+host_run_free (HostRun *run)
+{
+  if (run->wait_error != NULL)
+    g_error_free (run->wait_error);
+
+  g_object_unref (run->event);
+  g_object_unref (run->kernel);
+
+  g_slice_free (HostRun, run);
+}
+
+static void
+host_run_worker (gpointer data, gpointer user_data)
+{
+  HostRun *run = data;
+  GoclKernelPrivate *priv = run->kernel->priv;
+  gint chunk;
+
+  /* idle threads keep picking the next chunk, so the load balances itself */
+  while ((chunk = g_atomic_int_add (&run->next_chunk, 1)) < run->n_chunks)
+    {
+      WorkSize offset;
+      WorkSize size;
+      gsize start;
+
+      start = (gsize) chunk * run->chunk_size;
+
+      memcpy (offset, run->offset, sizeof (WorkSize));
+      memcpy (size, run->size, sizeof (WorkSize));
+      offset[0] += start;
+      size[0] = MIN (run->chunk_size, run->size[0] - start);
+
+      priv->native_func (run->kernel, offset, size, priv->native_data);
+    }
+
+  if (g_atomic_int_dec_and_test (&run->active_workers))
+    {
+      run->resolver_func (run->event, NULL);
+      host_run_free (run);
+    }
+}
+
+static void
+host_run_start (HostRun *run)
+{
+  guint i;
+
+  if (run->wait_error != NULL)
+    {
+      run->resolver_func (run->event, run->wait_error);
+      host_run_free (run);
+      return;
+    }
+
+  g_mutex_lock (&host_pool_mutex);
+  if (host_pool == NULL)
+    host_pool = g_thread_pool_new (host_run_worker,
+                                   NULL,
+                                   g_get_num_processors (),
+                                   FALSE,
+                                   NULL);
+  g_mutex_unlock (&host_pool_mutex);
+
+  for (i = 0; i < run->n_workers; i++)
+    g_thread_pool_push (host_pool, run, NULL);
+}
+
+static void
+host_run_on_wait_event (GoclEvent *event,
+                        GError    *error,
+                        gpointer   user_data)
+{
+  HostRun *run = user_data;
+
+  if (error != NULL)
+    {
+      GError *wait_error = g_error_copy (error);
+
+      if (! g_atomic_pointer_compare_and_exchange (&run->wait_error,
+                                                   NULL,
+                                                   wait_error))
+        {
+          g_error_free (wait_error);
+        }
+    }
+
+  if (g_atomic_int_dec_and_test (&run->pending_waits))
+    host_run_start (run);
+}
+
+/* executes the native implementation of the kernel on host threads, once all
+ * the events in @event_wait_list trigger. Returns a new reference to the event
+ * of the execution, or %NULL on error */
+static GoclEvent *
+run_on_host (GoclKernel  *self,
+             GoclEvent  **event_wait_list,
+             guint        event_wait_list_len)
+{
+  GoclKernelPrivate *priv = self->priv;
+  GoclKernel *kernel;
+  GoclEvent *event;
+  HostRun *run;
+  gsize granularity;
+  guint n_threads;
+  guint i;
+
+  if (priv->global_work_size[0] == 0)
+    {
+      g_set_error (gocl_error_prepare (),
+                   GOCL_OPENCL_ERROR,
+                   CL_INVALID_GLOBAL_WORK_SIZE,
+                   "A global work size must be set to run native kernel '%s'",
+                   priv->name);
+      return NULL;
+    }
+
+  /* the execution works on a copy, so the kernel can be set up again right
+     away */
+  kernel = gocl_kernel_clone (self);
+  if (kernel == NULL)
+    return NULL;
+
+  event = gocl_event_new (NULL, NULL);
+
+  run = g_slice_new0 (HostRun);
+  run->kernel = kernel;
+  run->event = g_object_ref (event);
+  run->resolver_func = gocl_event_steal_resolver_func (event);
+
+  for (i = 0; i < 3; i++)
+    {
+      run->offset[i] = i < priv->work_dim ? priv->global_work_offset[i] : 0;
+      run->size[i] = i < priv->work_dim ? priv->global_work_size[i] : 1;
+    }
+
+  /* chunks are kept a multiple of the local work size, if any */
+  n_threads = g_get_num_processors ();
+  granularity = MAX (priv->local_work_size[0], 1);
+  run->chunk_size = run->size[0] / (n_threads * HOST_CHUNKS_PER_THREAD);
+  run->chunk_size = ((run->chunk_size + granularity - 1) / granularity) *
+    granularity;
+  run->chunk_size = MAX (run->chunk_size, granularity);
+
+  run->n_chunks = (run->size[0] + run->chunk_size - 1) / run->chunk_size;
+  run->next_chunk = 0;
+  run->n_workers = MIN ((guint) run->n_chunks, n_threads);
+  run->active_workers = run->n_workers;
+
+  /* the extra count keeps the run from starting while callbacks are still
+     being registered */
+  run->pending_waits = event_wait_list_len + 1;
+  for (i = 0; i < event_wait_list_len; i++)
+    gocl_event_then_full (event_wait_list[i],
+                          GOCL_EVENT_DISPATCH_DIRECT,
+                          host_run_on_wait_event,
+                          run);
+  host_run_on_wait_event (NULL, NULL, run);
+
+  return event;
+}
+
+static void
+host_task_on_complete (GoclEvent *event,
+                       GError    *error,
+                       gpointer   user_data)
+{
+  GTask *task = G_TASK (user_data);
+
+  if (error != NULL)
+    g_task_return_error (task, g_error_copy (error));
+  else
+    g_task_return_boolean (task, TRUE);
+
+  g_object_unref (task);
+}
+
+/* hands the event of a host execution over to the application, which does
+   not own it unless in headless mode */
+static GoclEvent *
+host_event_to_caller (GoclEvent *event)
+{
+  if (event != NULL)
+    gocl_event_idle_unref (event);
+
+  return event;
+}
+
+static GoclEvent *
+run_on_host_list (GoclKernel *self, GList *event_wait_list)
+{
+  GoclEvent **events;
+  guint len;
+  guint i;
+
+  len = g_list_length (event_wait_list);
+  events = g_newa (GoclEvent *, MAX (len, 1));
+  for (i = 0; i < len; i++, event_wait_list = event_wait_list->next)
+    events[i] = event_wait_list->data;
+
+  return run_on_host (self, events, len);
+}
+
+static cl_int
+kernel_enqueue (GoclKernel      *self,
+                GoclQueue       *queue,
+                guint            event_wait_list_len,
+                const cl_event  *event_wait_list,
+                cl_event        *out_event)
+{
+  GoclBufferAccess *accesses;
+  guint n_accesses;
+  Slice slice;
+
+  init_slice (self, queue, &slice);
+
+  accesses = g_newa (GoclBufferAccess, self->priv->args->len);
+  n_accesses = get_buffer_accesses (self, accesses);
+
+  return gocl_queue_enqueue (queue,
+                             accesses,
+                             n_accesses,
+                             event_wait_list_len,
+                             event_wait_list,
+                             out_event,
+                             enqueue_slice,
+                             &slice);
+}
+
+/* public */
+
+/**
+ * gocl_kernel_get_kernel:
+ * @self: The #GoclKernel
+ *
+ * Retrieves the internal OpenCL #cl_kernel object. This is not normally
+ * called by applications. It is rather a low-level, internal API.
+ *
+ * Returns: (transfer none) (type guint64): The internal #cl_kernel object
+ **/
+cl_kernel
+gocl_kernel_get_kernel (GoclKernel *self)
+{
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+
+  return self->priv->kernel;
+}
+
+/**
+ * gocl_kernel_dup_kernel: (skip)
+ * @self: The #GoclKernel
+ *
+ * Creates a new OpenCL kernel object for the same program and function as
+ * this kernel, with all the arguments set so far applied to it.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: A new #cl_kernel to be released with clReleaseKernel(), or %NULL
+ * on error
+ **/
+cl_kernel
+gocl_kernel_dup_kernel (GoclKernel *self)
+{
+  cl_kernel kernel;
+  cl_int err_code;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+
+  kernel = clCreateKernel (gocl_program_get_program (self->priv->program),
+                           self->priv->name,
+                           &err_code);
+  if (gocl_error_check_opencl_internal (err_code))
+    return NULL;
+
+  for (i = 0; i < self->priv->args->len; i++)
+    {
+      KernelArg *arg;
+
+      arg = &g_array_index (self->priv->args, KernelArg, i);
+      if (! arg->set)
+        continue;
+
+      err_code = clSetKernelArg (kernel, i, arg->size, get_arg_value (arg));
+      if (gocl_error_check_opencl_internal (err_code))
+        {
+          clReleaseKernel (kernel);
+          return NULL;
+        }
+    }
+
+  return kernel;
+}
+
+/**
+ * gocl_kernel_get_work_size: (skip)
+ * @self: The #GoclKernel
+ * @work_dim: (out): Location for the work dimension
+ * @global_work_offset: (out): Array of 3 elements for the global work offsets
+ * @global_work_size: (out): Array of 3 elements for the global work sizes
+ * @local_work_size: (out): Array of 3 elements for the local work sizes
+ *
+ * Retrieves the work dimension, offsets and sizes currently set in this
+ * kernel.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ **/
+void
+gocl_kernel_get_work_size (GoclKernel *self,
+                           guint8     *work_dim,
+                           gsize      *global_work_offset,
+                           gsize      *global_work_size,
+                           gsize      *local_work_size)
+{
+  g_return_if_fail (GOCL_IS_KERNEL (self));
+
+  *work_dim = self->priv->work_dim;
+  memcpy (global_work_offset,
+          self->priv->global_work_offset,
+          sizeof (WorkSize));
+  memcpy (global_work_size, self->priv->global_work_size, sizeof (WorkSize));
+  memcpy (local_work_size, self->priv->local_work_size, sizeof (WorkSize));
+}
+
+/**
+ * gocl_kernel_get_argument_buffer: (skip)
+ * @self: The #GoclKernel
+ * @index: The index of the argument
+ *
+ * Retrieves the #GoclBuffer bound to the argument at @index with
+ * gocl_kernel_set_argument_buffer(), if any.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: (transfer none) (allow-none): A #GoclBuffer, or %NULL
+ **/
+GoclBuffer *
+gocl_kernel_get_argument_buffer (GoclKernel *self, guint index)
+{
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+
+  if (index >= self->priv->args->len)
+    return NULL;
+
+  return g_array_index (self->priv->args, KernelArg, index).buffer;
+}
+
+/**
+ * gocl_kernel_get_num_arguments_set: (skip)
+ * @self: The #GoclKernel
+ *
+ * Retrieves the number of argument slots tracked by this kernel, which is
+ * the highest argument index set so far plus one.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: The number of argument slots
+ **/
+guint
+gocl_kernel_get_num_arguments_set (GoclKernel *self)
+{
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), 0);
+
+  return self->priv->args->len;
+}
+
+/**
+ * gocl_kernel_set_argument:
+ * @self: The #GoclKernel
+ * @index: The index of this argument in the kernel function
+ * @size: The size of @buffer, in bytes
+ * @buffer: A pointer to an arbitrary block of memory
+ *
+ * Sets the value of the kernel argument at @index, as an arbitrary block of
+ * memory.
+ *
+ * Setting an argument to the value it already has does not reach the OpenCL
+ * implementation, so applications can set all the arguments before every
+ * execution without any cost.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_argument (GoclKernel      *self,
+                          guint            index,
+                          gsize            size,
+                          const gpointer  *buffer)
+{
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+
+  return set_arg (self, index, size, buffer, NULL);
+}
+
+/**
+ * gocl_kernel_set_argument_int32:
+ * @self: The #GoclKernel
+ * @index: The index of this argument in the kernel function
+ * @num_elements: The number of int32 elements in @buffer
+ * @buffer: (array length=num_elements) (element-type guint32): Array of int32
+ * values
+ *
+ * Sets the value of the kernel argument at @index, as an array of int32.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_argument_int32 (GoclKernel  *self,
+                                guint        index,
+                                gsize        num_elements,
+                                gint32      *buffer)
+{
+  return gocl_kernel_set_argument (self,
+                                   index,
+                                   sizeof (cl_uint) * num_elements,
+                                   (const gpointer) buffer);
+}
+
+/**
+ * gocl_kernel_set_argument_float:
+ * @self: The #GoclKernel
+ * @index: The index of this argument in the kernel function
+ * @num_elements: The number of float elements in @buffer
+ * @buffer: (array length=num_elements) (element-type gfloat): Array of float
+ * values
+ *
+ * Sets the value of the kernel argument at @index, as an array of floats.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_argument_float (GoclKernel  *self,
+                                guint        index,
+                                gsize        num_elements,
+                                gfloat      *buffer)
+{
+  return gocl_kernel_set_argument (self,
+                                   index,
+                                   sizeof (cl_float) * num_elements,
+                                   (const gpointer) buffer);
+}
+
+/**
+ * gocl_kernel_set_argument_buffer:
+ * @self: The #GoclKernel
+ * @index: The index of this argument in the kernel function
+ * @buffer: A #GoclBuffer
+ *
+ * Sets the value of the kernel argument at @index, as a buffer object.
+ *
+ * The kernel keeps a reference to @buffer while it stays bound, so that
+ * executions in out-of-order queues can be ordered automatically against
+ * other commands accessing the same buffer. See #GoclQueue for details.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_argument_buffer (GoclKernel  *self,
+                                 guint        index,
+                                 GoclBuffer  *buffer)
+{
+  cl_mem buf;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_BUFFER (buffer), FALSE);
+
+  buf = gocl_buffer_get_buffer (buffer);
+
+  return set_arg (self, index, sizeof (cl_mem), &buf, buffer);
+}
+
+/**
+ * gocl_kernel_set_arguments_from_variant:
+ * @self: The #GoclKernel
+ * @first_index: The index of the kernel argument set from the first element
+ * @arguments: A #GVariant tuple
+ *
+ * Sets several consecutive kernel arguments at once, from the elements of the
+ * @arguments tuple. The first element sets the argument at @first_index, the
+ * second element the next argument, and so on. If @arguments is floating, it
+ * is consumed.
+ *
+ * Elements of integer types (including 'y') are set with their size.
+ * Since #GVariant has no single precision type, and double precision is
+ * optional in OpenCL devices, 'd' elements are set as a float. Arrays of
+ * those types are set as vectors, for example "ai" for an int4 argument.
+ * Any other value, like a double or a struct, can be set from its bytes
+ * with an "ay" array. Buffers are set with gocl_kernel_set_argument_buffer().
+ *
+ * Setting stops at the first element that fails, leaving the previous ones
+ * set.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_arguments_from_variant (GoclKernel *self,
+                                        guint       first_index,
+                                        GVariant   *arguments)
+{
+  gsize n_children;
+  gsize i;
+  gboolean result = TRUE;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (arguments != NULL, FALSE);
+  g_return_val_if_fail (g_variant_is_of_type (arguments,
+                                              G_VARIANT_TYPE_TUPLE), FALSE);
+
+  g_variant_ref_sink (arguments);
+
+  n_children = g_variant_n_children (arguments);
+  for (i = 0; i < n_children && result; i++)
+    {
+      GVariant *child;
+      const gchar *type_string;
+      const gchar *element_type;
+      guint index = first_index + i;
+
+      child = g_variant_get_child_value (arguments, i);
+      type_string = g_variant_get_type_string (child);
+
+      /* skip the array prefix, arrays are set as vectors */
+      element_type = type_string[0] == 'a' ? type_string + 1 : type_string;
+
+      if (g_strcmp0 (element_type, "d") == 0)
+        {
+          const gdouble *values;
+          gsize n_values;
+          cl_float *floats;
+          gsize j;
+
+          values = g_variant_get_data (child);
+          n_values = g_variant_get_size (child) / sizeof (gdouble);
+
+          floats = g_newa (cl_float, MAX (n_values, 1));
+          for (j = 0; j < n_values; j++)
+            floats[j] = values[j];
+
+          result = set_arg (self,
+                            index,
+                            sizeof (cl_float) * n_values,
+                            floats,
+                            NULL);
+        }
+      else if (element_type[0] != '\0' &&
+               element_type[1] == '\0' &&
+               strchr ("ynqiuxth", element_type[0]) != NULL)
+        {
+          /* fixed-size values are serialized in host byte order, just as
+           * clSetKernelArg() expects them */
+          result = set_arg (self,
+                            index,
+                            g_variant_get_size (child),
+                            g_variant_get_data (child),
+                            NULL);
+        }
+      else
+        {
+          g_set_error (gocl_error_prepare (),
+                       GOCL_OPENCL_ERROR,
+                       CL_INVALID_ARG_VALUE,
+                       "Cannot set argument %u of kernel '%s' from a value "
+                       "of type '%s'",
+                       index,
+                       self->priv->name,
+                       type_string);
+          result = FALSE;
+        }
+
+      g_variant_unref (child);
+    }
+
+  g_variant_unref (arguments);
+
+  return result;
+}
+
+/**
+ * gocl_kernel_get_argument_value:
+ * @self: The #GoclKernel
+ * @index: The index of the argument
+ * @size: (out) (allow-none): Location for the size of the value, or %NULL
+ *
+ * Retrieves the value last set for the kernel argument at @index, as passed
+ * to gocl_kernel_set_argument() and similar methods. For buffer arguments,
+ * this is the internal #cl_mem object. This is mostly useful in native
+ * implementations of kernels (see #GoclNativeKernelFunc), which take host
+ * data, like pointers, as plain values.
+ *
+ * Returns: (transfer none): The value of the argument, or %NULL if it has no
+ * value, as is the case of arguments not set yet
+ **/
+gconstpointer
+gocl_kernel_get_argument_value (GoclKernel *self, guint index, gsize *size)
+{
+  const KernelArg *arg;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+
+  if (size != NULL)
+    *size = 0;
+
+  if (index >= self->priv->args->len)
+    return NULL;
+
+  arg = &g_array_index (self->priv->args, KernelArg, index);
+  if (! arg->set)
+    return NULL;
+
+  if (size != NULL)
+    *size = arg->size;
+
+  return arg->has_value ? get_arg_value (arg) : NULL;
+}
+
+/**
+ * gocl_kernel_run_in_device_sync:
+ * @self: The #GoclKernel
+ * @device: (allow-none): A #GoclDevice to run the kernel on, or %NULL for
+ * kernels of native programs
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Runs the kernel on the specified device, blocking the program
+ * until the kernel execution finishes. For non-blocking version,
+ * gocl_kernel_run_in_device() is provided.
+ *
+ * If @event_wait_list is provided, the kernel execution will start
+ * only when all the events in the list have triggered.
+ *
+ * This is equivalent to calling gocl_kernel_run_in_queue_sync() with the
+ * default queue of @device.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_run_in_device_sync (GoclKernel  *self,
+                                GoclDevice  *device,
+                                GList       *event_wait_list)
+{
+  GoclQueue *queue;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (self->priv->native_func != NULL ||
+                        GOCL_IS_DEVICE (device), FALSE);
+
+  if (self->priv->native_func != NULL)
+    {
+      GoclEvent *event;
+      gboolean result;
+
+      event = run_on_host_list (self, event_wait_list);
+      if (event == NULL)
+        return FALSE;
+
+      result = gocl_event_wait (event, -1, gocl_error_prepare ());
+      g_object_unref (event);
+
+      return result;
+    }
+
+  queue = gocl_device_get_default_queue (device);
+  if (queue == NULL)
+    return FALSE;
+
+  return gocl_kernel_run_in_queue_sync (self, queue, event_wait_list);
+}
+
+/**
+ * gocl_kernel_run_in_device:
+ * @self: The #GoclKernel
+ * @device: (allow-none): A #GoclDevice to run the kernel on, or %NULL for
+ * kernels of native programs
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Runs the kernel on the specified device, asynchronously. A #GoclEvent
+ * is returned, and can be used to get notified when the execution finishes,
+ * or as wait event input to other operations on the device.
+ *
+ * If @event_wait_list is provided, the kernel execution will start
+ * only when all the events in the list have triggered.
+ *
+ * This is equivalent to calling gocl_kernel_run_in_queue() with the
+ * default queue of @device. Kernels of programs created with
+ * gocl_program_new_native() run on host threads instead, and @device is
+ * ignored. Their event can only be waited for by other native kernels and
+ * by the host.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when execution
+ * finishes, or %NULL if the device's default queue could not be created
+ **/
+GoclEvent *
+gocl_kernel_run_in_device (GoclKernel *self,
+                           GoclDevice *device,
+                           GList      *event_wait_list)
+{
+  GoclQueue *queue;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+  g_return_val_if_fail (self->priv->native_func != NULL ||
+                        GOCL_IS_DEVICE (device), NULL);
+
+  if (self->priv->native_func != NULL)
+    return host_event_to_caller (run_on_host_list (self, event_wait_list));
+
+  queue = gocl_device_get_default_queue (device);
+  if (queue == NULL)
+    return NULL;
+
+  return gocl_kernel_run_in_queue (self, queue, event_wait_list);
+}
+
+/**
+ * gocl_kernel_run_in_queue_sync:
+ * @self: The #GoclKernel
+ * @queue: A #GoclQueue to enqueue the kernel execution in
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Runs the kernel on the device of @queue, blocking the program until the
+ * kernel execution finishes. For non-blocking version,
+ * gocl_kernel_run_in_queue() is provided.
+ *
+ * If @event_wait_list is provided, the kernel execution will start
+ * only when all the events in the list have triggered.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_run_in_queue_sync (GoclKernel *self,
+                               GoclQueue  *queue,
+                               GList      *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  cl_event *_event_wait_list;
+  guint event_wait_list_len;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+
+  _event_wait_list = gocl_event_list_to_array (event_wait_list,
+                                               &event_wait_list_len);
+
+  err_code = kernel_enqueue (self,
+                             queue,
+                             event_wait_list_len,
+                             _event_wait_list,
+                             &event);
+  g_free (_event_wait_list);
+
+  if (gocl_error_check_opencl_internal (err_code))
+    return FALSE;
+
+  clWaitForEvents (1, &event);
+  clReleaseEvent (event);
+
+  return TRUE;
+}
+
+/**
+ * gocl_kernel_run_in_queue:
+ * @self: The #GoclKernel
+ * @queue: A #GoclQueue to enqueue the kernel execution in
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Runs the kernel on the device of @queue, asynchronously. A #GoclEvent is
+ * returned, and can be used to get notified when the execution finishes,
+ * or as wait event input to other operations.
+ *
+ * Kernels enqueued in different queues of a device may execute concurrently.
+ * A queue from the pool of a device can be obtained with
+ * gocl_device_get_queue().
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when execution
+ * finishes
+ **/
+GoclEvent *
+gocl_kernel_run_in_queue (GoclKernel *self,
+                          GoclQueue  *queue,
+                          GList      *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  cl_event *_event_wait_list;
+  guint event_wait_list_len;
+  GoclEvent *_event;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+
+  _event_wait_list = gocl_event_list_to_array (event_wait_list,
+                                               &event_wait_list_len);
+
+  err_code = kernel_enqueue (self,
+                             queue,
+                             event_wait_list_len,
+                             _event_wait_list,
+                             &event);
+  g_free (_event_wait_list);
+
+  _event = gocl_event_new_from_enqueue (queue, err_code, event);
+  if (err_code == CL_SUCCESS)
+    gocl_event_set_event_wait_list (_event, event_wait_list);
+
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
+
+/**
+ * gocl_kernel_run_in_device_v:
+ * @self: The #GoclKernel
+ * @device: (allow-none): A #GoclDevice to run the kernel on, or %NULL for
+ * kernels of native programs
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array of
+ * #GoclEvent objects to wait for, or %NULL
+ * @event_wait_list_len: The length of @event_wait_list
+ *
+ * Like gocl_kernel_run_in_device(), but takes the events to wait for as a
+ * caller-owned array. This avoids allocating memory and walking a list on
+ * every call, for applications issuing many small kernel executions.
+ *
+ * The array is only accessed during the call, and no references to the
+ * events in it are kept.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when execution
+ * finishes, or %NULL if the device's default queue could not be created
+ **/
+GoclEvent *
+gocl_kernel_run_in_device_v (GoclKernel  *self,
+                             GoclDevice  *device,
+                             GoclEvent  **event_wait_list,
+                             guint        event_wait_list_len)
+{
+  GoclQueue *queue;
+  cl_event inline_list[GOCL_EVENT_INLINE_WAIT_LIST_SIZE];
+  cl_event *_event_wait_list;
+  cl_event event;
+  cl_int err_code;
+  GoclEvent *_event;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+  g_return_val_if_fail (self->priv->native_func != NULL ||
+                        GOCL_IS_DEVICE (device), NULL);
+
+  if (self->priv->native_func != NULL)
+    return host_event_to_caller (run_on_host (self,
+                                              event_wait_list,
+                                              event_wait_list_len));
+
+  queue = gocl_device_get_default_queue (device);
+  if (queue == NULL)
+    return NULL;
+
+  _event_wait_list = gocl_event_array_to_cl_array (event_wait_list,
+                                                   event_wait_list_len,
+                                                   inline_list);
+
+  err_code = kernel_enqueue (self,
+                             queue,
+                             event_wait_list_len,
+                             _event_wait_list,
+                             &event);
+
+  if (_event_wait_list != inline_list)
+    g_free (_event_wait_list);
+
+  _event = gocl_event_new_from_enqueue (queue, err_code, event);
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
+
+/**
+ * gocl_kernel_run_in_device_detached:
+ * @self: The #GoclKernel
+ * @device: (allow-none): A #GoclDevice to run the kernel on, or %NULL for
+ * kernels of native programs
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array of
+ * #GoclEvent objects to wait for, or %NULL
+ * @event_wait_list_len: The length of @event_wait_list
+ *
+ * Enqueues the kernel execution like gocl_kernel_run_in_device_v(), but
+ * without creating any event to track its completion. This is the cheapest
+ * way of launching a kernel that is never waited for individually.
+ *
+ * When a synchronization point is needed, gocl_queue_enqueue_marker() can be
+ * called on the device's default queue to obtain a #GoclEvent that triggers
+ * once all the previously enqueued commands complete.
+ *
+ * Returns: %TRUE if the execution was enqueued, %FALSE on error
+ **/
+gboolean
+gocl_kernel_run_in_device_detached (GoclKernel  *self,
+                                    GoclDevice  *device,
+                                    GoclEvent  **event_wait_list,
+                                    guint        event_wait_list_len)
+{
+  GoclQueue *queue;
+  cl_event inline_list[GOCL_EVENT_INLINE_WAIT_LIST_SIZE];
+  cl_event *_event_wait_list;
+  cl_int err_code;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (self->priv->native_func != NULL ||
+                        GOCL_IS_DEVICE (device), FALSE);
+
+  if (self->priv->native_func != NULL)
+    {
+      GoclEvent *event;
+
+      event = run_on_host (self, event_wait_list, event_wait_list_len);
+      if (event == NULL)
+        return FALSE;
+
+      g_object_unref (event);
+
+      return TRUE;
+    }
+
+  queue = gocl_device_get_default_queue (device);
+  if (queue == NULL)
+    return FALSE;
+
+  _event_wait_list = gocl_event_array_to_cl_array (event_wait_list,
+                                                   event_wait_list_len,
+                                                   inline_list);
+
+  err_code = kernel_enqueue (self,
+                             queue,
+                             event_wait_list_len,
+                             _event_wait_list,
                              NULL);
-      resolver_func = gocl_event_steal_resolver_func (_event);
-      resolver_func (_event, error);
-      g_error_free (error);
+
+  if (_event_wait_list != inline_list)
+    g_free (_event_wait_list);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
+/**
+ * gocl_kernel_run_in_device_async:
+ * @self: The #GoclKernel
+ * @device: (allow-none): A #GoclDevice to run the kernel on, or %NULL for
+ * kernels of native programs
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
+ * @callback: (scope async): A #GAsyncReadyCallback to call when the execution
+ * finishes
+ * @user_data: (allow-none): Arbitrary data to pass in @callback, or %NULL
+ *
+ * Runs the kernel on the specified device asynchronously, following the GIO
+ * asynchronous pattern. When the execution finishes, @callback is called and
+ * gocl_kernel_run_in_device_finish() should be used to get the result.
+ *
+ * The kernel arguments and work sizes are captured when this method is
+ * called, so they can be changed right after it returns.
+ *
+ * If @event_wait_list is provided, the kernel execution will start only when
+ * all the events in the list have triggered. If @cancellable is cancelled
+ * before that, the kernel never reaches the device and the operation finishes
+ * with %G_IO_ERROR_CANCELLED. Cancelling a kernel that is already executing has
+ * no effect.
+ **/
+void
+gocl_kernel_run_in_device_async (GoclKernel          *self,
+                                 GoclDevice          *device,
+                                 GList               *event_wait_list,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  GTask *task;
+  GoclQueue *queue;
+  GoclBufferAccess *accesses;
+  guint n_accesses;
+  Slice slice;
+
+  g_return_if_fail (GOCL_IS_KERNEL (self));
+  g_return_if_fail (self->priv->native_func != NULL ||
+                    GOCL_IS_DEVICE (device));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gocl_kernel_run_in_device_async);
+
+  if (self->priv->native_func != NULL)
+    {
+      GoclEvent *event;
+
+      event = run_on_host_list (self, event_wait_list);
+      if (event == NULL)
+        {
+          g_task_return_error (task, gocl_error_get_last ());
+          g_object_unref (task);
+        }
+      else
+        {
+          gocl_event_then_full (event,
+                                GOCL_EVENT_DISPATCH_DIRECT,
+                                host_task_on_complete,
+                                task);
+          g_object_unref (event);
+        }
+
+      return;
+    }
+
+  queue = gocl_device_get_default_queue (device);
+  if (queue == NULL)
+    {
+      g_task_return_error (task, gocl_error_get_last ());
+      g_object_unref (task);
+      return;
+    }
+
+  init_slice (self, queue, &slice);
+
+  accesses = g_newa (GoclBufferAccess, self->priv->args->len);
+  n_accesses = get_buffer_accesses (self, accesses);
+
+  /* the command is enqueued before this returns, so the slice can live in
+     the stack */
+  gocl_event_enqueue_task (task,
+                           queue,
+                           event_wait_list,
+                           accesses,
+                           n_accesses,
+                           enqueue_slice,
+                           &slice);
+}
+
+/**
+ * gocl_kernel_run_in_device_finish:
+ * @self: The #GoclKernel
+ * @result: The #GAsyncResult object passed to the callback
+ * @error: (out) (allow-none): A pointer to a #GError, or %NULL
+ *
+ * Finishes an asynchronous kernel execution started with
+ * gocl_kernel_run_in_device_async().
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_run_in_device_finish (GoclKernel    *self,
+                                  GAsyncResult  *result,
+                                  GError       **error)
+{
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, self), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/**
+ * gocl_kernel_set_work_dimension:
+ * @self: The #GoclKernel
+ * @work_dim: The work dimension
+ *
+ * Sets the work dimension (1, 2, 3) to use when executing the kernel.
+ **/
+void
+gocl_kernel_set_work_dimension (GoclKernel *self, guint8 work_dim)
+{
+  g_return_if_fail (GOCL_IS_KERNEL (self));
+  g_return_if_fail (work_dim > 0 && work_dim <= 3);
+
+  self->priv->work_dim = work_dim;
+}
+
+/**
+ * gocl_kernel_set_global_work_size:
+ * @self: The #GoclKernel
+ * @size1: global work size for the first dimension
+ * @size2: global work size for the second dimension
+ * @size3: global work size for the third dimension
+ *
+ * Sets the global work sizes to use when executing the kernel, corresponding
+ * to the first, second, and third dimensions, respectively. By default, the
+ * sizes are all zeros.
+ *
+ * If the @size1 value is zero, it means no global work size is specified and
+ * %NULL will be used when enqueuing the kernel.
+ **/
+void
+gocl_kernel_set_global_work_size (GoclKernel *self,
+                                  gsize       size1,
+                                  gsize       size2,
+                                  gsize       size3)
+{
+  g_return_if_fail (GOCL_IS_KERNEL (self));
+
+  self->priv->global_work_size[0] = size1;
+  self->priv->global_work_size[1] = size2;
+  self->priv->global_work_size[2] = size3;
+}
+
+/**
+ * gocl_kernel_set_global_work_offset:
+ * @self: The #GoclKernel
+ * @offset1: global work offset for the first dimension
+ * @offset2: global work offset for the second dimension
+ * @offset3: global work offset for the third dimension
+ *
+ * Sets the offsets added to the global ID of each work-item, corresponding to
+ * the first, second, and third dimensions, respectively. This allows
+ * executing the kernel on a part of a larger index space. By default, the
+ * offsets are all zeros, and %NULL is used when enqueuing the kernel.
+ **/
+void
+gocl_kernel_set_global_work_offset (GoclKernel *self,
+                                    gsize       offset1,
+                                    gsize       offset2,
+                                    gsize       offset3)
+{
+  g_return_if_fail (GOCL_IS_KERNEL (self));
+
+  self->priv->global_work_offset[0] = offset1;
+  self->priv->global_work_offset[1] = offset2;
+  self->priv->global_work_offset[2] = offset3;
+}
+
+/**
+ * gocl_kernel_set_local_work_size:
+ * @self: The #GoclKernel
+ * @size1: local work size for the first dimension
+ * @size2: local work size for the second dimension
+ * @size3: local work size for the third dimension
+ *
+ * Sets the local work sizes to use when executing the kernel, corresponding
+ * to the first, second, and third dimensions, respectively. By default, the
+ * sizes are all zeros.
+ *
+ * If the @size1 value is zero, it means no local work size is specified and
+ * %NULL will be used when enqueuing the kernel.
+ **/
+void
+gocl_kernel_set_local_work_size (GoclKernel *self,
+                                 gsize       size1,
+                                 gsize       size2,
+                                 gsize       size3)
+{
+  g_return_if_fail (GOCL_IS_KERNEL (self));
+
+  self->priv->local_work_size[0] = size1;
+  self->priv->local_work_size[1] = size2;
+  self->priv->local_work_size[2] = size3;
+}
+
+/**
+ * gocl_kernel_tune_local_work_size_sync:
+ * @self: The #GoclKernel
+ * @device: The #GoclDevice to tune the kernel for
+ *
+ * Chooses the local work size that runs the kernel fastest on @device, for the
+ * current global work size. The size found is used by the executions of the
+ * kernel on @device while automatic tuning is enabled (see
+ * gocl_kernel_set_autotune()). The local work size set with
+ * gocl_kernel_set_local_work_size() is not changed.
+ *
+ * The candidates are the choice of the OpenCL implementation, and the power of
+ * two sizes that divide the global work size, are multiples of the preferred
+ * work-group size multiple of the kernel, and fit in the maximum work-group
+ * size of both the kernel and @device (see
+ * gocl_device_get_max_work_group_size()). Each candidate is measured by
+ * running the kernel, with its current arguments, several times on a
+ * profiling queue of @device, and blocking until they finish. Tuning is
+ * therefore only meaningful for kernels whose results do not depend on
+ * previous executions. These runs do not wait for the commands pending in
+ * other queues, so the commands that write the input buffers of the kernel
+ * must have finished before calling this method.
+ *
+ * The result is cached by kernel source code, device model and driver, and
+ * global work size class (the global size of each dimension rounded up to a
+ * power of two), so other kernels created from the same sources reuse it. The
+ * cache is saved in the user cache directory, and persists across runs. When
+ * a cached size does not divide the current global work size, the choice of
+ * the OpenCL implementation is used.
+ *
+ * A global work size must be set.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_tune_local_work_size_sync (GoclKernel *self, GoclDevice *device)
+{
+  GoclKernelPrivate *priv;
+  WorkSize size_class;
+  WorkSize best;
+  gchar *group;
+  gchar *key;
+  gboolean found;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_DEVICE (device), FALSE);
+
+  priv = self->priv;
+
+  if (priv->global_work_size[0] == 0)
+    {
+      g_set_error (gocl_error_prepare (),
+                   GOCL_OPENCL_ERROR,
+                   CL_INVALID_GLOBAL_WORK_SIZE,
+                   "A global work size must be set to tune the local "
+                   "work size of kernel '%s'",
+                   priv->name);
+      return FALSE;
+    }
+
+  get_size_class (self, size_class);
+  key = get_tuning_key (self, device, size_class, &group);
+
+  found = lookup_tuned_size (group, key, best);
+  if (! found)
+    {
+      found = find_best_local_size (self, device, best);
+      if (found)
+        store_tuned_size (group, key, best);
+    }
+
+  g_free (key);
+  g_free (group);
+
+  if (! found)
+    return FALSE;
+
+  g_object_ref (device);
+  if (priv->tuned_device != NULL)
+    g_object_unref (priv->tuned_device);
+  priv->tuned_device = device;
+  memcpy (priv->tuned_size_class, size_class, sizeof (WorkSize));
+  priv->tuned_found = TRUE;
+  memcpy (priv->tuned_local_work_size, best, sizeof (WorkSize));
+
+  return TRUE;
+}
+
+/**
+ * gocl_kernel_set_autotune:
+ * @self: The #GoclKernel
+ * @autotune: Whether to tune the local work size automatically
+ *
+ * Enables or disables the use of tuned local work sizes. When enabled, the
+ * kernel runs on each device and global work size class with the local work
+ * size found by gocl_kernel_tune_local_work_size_sync(), either in this run of
+ * the application or, through the persistent cache, in a previous one. The
+ * kernel itself is never run to measure anything, so executions are not
+ * delayed and buffers are not touched outside the order of the commands of
+ * the application.
+ *
+ * When no size has been tuned for a device and size class, or the tuned size
+ * does not divide the current global work size, the local work size is chosen
+ * as if automatic tuning was disabled. The local work size set with
+ * gocl_kernel_set_local_work_size() is kept, and used again once automatic
+ * tuning is disabled. By default, automatic tuning is disabled.
+ **/
+void
+gocl_kernel_set_autotune (GoclKernel *self, gboolean autotune)
+{
+  g_return_if_fail (GOCL_IS_KERNEL (self));
+
+  self->priv->autotune = autotune;
+}
+
+/**
+ * gocl_kernel_set_auto_local_work_size:
+ * @self: The #GoclKernel
+ * @auto_size: Whether to choose the local work size automatically
+ *
+ * Enables or disables the automatic choice of the local work size. When
+ * enabled, every time the kernel is enqueued with a different global work
+ * size or on a different device, a local work size is chosen that divides
+ * the global work size, respects the limits of the kernel and the device
+ * (see gocl_kernel_get_work_group_size()), is a multiple of the preferred
+ * work-group size multiple when possible, and leaves enough work-groups to
+ * keep all the compute units of the device busy.
+ *
+ * When gocl_kernel_set_autotune() is also enabled, a tuned size takes
+ * precedence, and this choice is used where no size has been tuned. While
+ * enabled, the local work size set with gocl_kernel_set_local_work_size() is
+ * not used, but it is kept and used again once this is disabled. By default,
+ * it is disabled.
+ **/
+void
+gocl_kernel_set_auto_local_work_size (GoclKernel *self, gboolean auto_size)
+{
+  g_return_if_fail (GOCL_IS_KERNEL (self));
+
+  self->priv->auto_local_size = auto_size;
+}
+
+/**
+ * gocl_kernel_get_work_group_size:
+ * @self: The #GoclKernel
+ * @device: A #GoclDevice
+ *
+ * Retrieves the maximum work-group size that can be used to run the kernel on
+ * @device, by querying the @CL_KERNEL_WORK_GROUP_SIZE info key through
+ * clGetKernelWorkGroupInfo(). This depends on the resources the kernel uses,
+ * and may be smaller than gocl_device_get_max_work_group_size().
+ *
+ * The work-group info of a kernel is queried once per device, and then
+ * cached.
+ *
+ * Returns: The maximum work-group size, or 0 on error
+ **/
+gsize
+gocl_kernel_get_work_group_size (GoclKernel *self, GoclDevice *device)
+{
+  const WorkGroupInfo *info;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), 0);
+  g_return_val_if_fail (GOCL_IS_DEVICE (device), 0);
+
+  info = get_work_group_info (self, device);
+
+  return info != NULL ? info->work_group_size : 0;
+}
+
+/**
+ * gocl_kernel_get_preferred_work_group_size_multiple:
+ * @self: The #GoclKernel
+ * @device: A #GoclDevice
+ *
+ * Retrieves the preferred multiple of the work-group size of the kernel on
+ * @device, as reported by the
+ * @CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE info key. Work-group sizes
+ * that are a multiple of it usually perform better. If the implementation
+ * does not report it, 1 is returned.
+ *
+ * Returns: The preferred work-group size multiple, or 0 on error
+ **/
+gsize
+gocl_kernel_get_preferred_work_group_size_multiple (GoclKernel *self,
+                                                    GoclDevice *device)
+{
+  const WorkGroupInfo *info;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), 0);
+  g_return_val_if_fail (GOCL_IS_DEVICE (device), 0);
+
+  info = get_work_group_info (self, device);
+
+  return info != NULL ? info->preferred_multiple : 0;
+}
+
+/**
+ * gocl_kernel_get_local_mem_size:
+ * @self: The #GoclKernel
+ * @device: A #GoclDevice
+ *
+ * Retrieves the amount of local memory, in bytes, used by the kernel on
+ * @device, as reported by the @CL_KERNEL_LOCAL_MEM_SIZE info key.
+ *
+ * Returns: The local memory size of the kernel, or 0 on error
+ **/
+guint64
+gocl_kernel_get_local_mem_size (GoclKernel *self, GoclDevice *device)
+{
+  const WorkGroupInfo *info;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), 0);
+  g_return_val_if_fail (GOCL_IS_DEVICE (device), 0);
+
+  info = get_work_group_info (self, device);
+
+  return info != NULL ? info->local_mem_size : 0;
+}
+
+/**
+ * gocl_kernel_get_private_mem_size:
+ * @self: The #GoclKernel
+ * @device: A #GoclDevice
+ *
+ * Retrieves the minimum amount of private memory, in bytes, used by each
+ * work-item of the kernel on @device, as reported by the
+ * @CL_KERNEL_PRIVATE_MEM_SIZE info key.
+ *
+ * Returns: The private memory size of the kernel, or 0 on error
+ **/
+guint64
+gocl_kernel_get_private_mem_size (GoclKernel *self, GoclDevice *device)
+{
+  const WorkGroupInfo *info;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), 0);
+  g_return_val_if_fail (GOCL_IS_DEVICE (device), 0);
+
+  info = get_work_group_info (self, device);
+
+  return info != NULL ? info->private_mem_size : 0;
+}
+
+/**
+ * gocl_kernel_run_in_queue_chunked:
+ * @self: The #GoclKernel
+ * @queue: A #GoclQueue to enqueue the kernel execution in
+ * @chunk_size: The number of work-items of the first dimension in each chunk
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Runs the kernel like gocl_kernel_run_in_queue(), but splits the first
+ * dimension of the global index space into chunks of @chunk_size work-items,
+ * each enqueued as a separate command with the corresponding global work
+ * offset. The queue is flushed after each chunk, so the device starts
+ * executing the first chunks while the rest are still being enqueued.
+ *
+ * This bounds the time the device spends on each command, so that commands
+ * enqueued in other queues of the device (see gocl_device_get_queue()) can be
+ * scheduled between the chunks of a long execution.
+ *
+ * If a local work size is set, @chunk_size is rounded up to a multiple of it.
+ * A global work size must be set. In out-of-order queues the chunks are
+ * ordered against each other like any other commands accessing the same
+ * buffers (see #GoclQueue).
+ *
+ * Returns: (transfer none): A #GoclEvent that triggers when all the chunks
+ * finish
+ **/
+GoclEvent *
+gocl_kernel_run_in_queue_chunked (GoclKernel *self,
+                                  GoclQueue  *queue,
+                                  gsize       chunk_size,
+                                  GList      *event_wait_list)
+{
+  GoclKernelPrivate *priv;
+  cl_event *_event_wait_list;
+  guint event_wait_list_len;
+  GoclBufferAccess *accesses;
+  guint n_accesses;
+  cl_event *chunk_events;
+  guint n_chunks;
+  Slice slice;
+  gsize local_size;
+  gsize done;
+  cl_event event = NULL;
+  cl_int err_code = CL_SUCCESS;
+  guint i;
+  GoclEvent *_event;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (chunk_size > 0, NULL);
+  g_return_val_if_fail (self->priv->global_work_size[0] > 0, NULL);
+
+  priv = self->priv;
+
+  init_slice (self, queue, &slice);
+
+  local_size = slice.local[0];
+  if (local_size > 0)
+    chunk_size = ((chunk_size + local_size - 1) / local_size) * local_size;
+
+  n_chunks = (priv->global_work_size[0] + chunk_size - 1) / chunk_size;
+  chunk_events = g_new (cl_event, n_chunks);
+
+  accesses = g_newa (GoclBufferAccess, priv->args->len);
+  n_accesses = get_buffer_accesses (self, accesses);
+
+  _event_wait_list = gocl_event_list_to_array (event_wait_list,
+                                               &event_wait_list_len);
+
+  done = 0;
+  for (i = 0; i < n_chunks; i++)
+    {
+      slice.offset[0] = priv->global_work_offset[0] + done;
+      slice.size[0] = MIN (chunk_size, priv->global_work_size[0] - done);
+
+      err_code = gocl_queue_enqueue (queue,
+                                     accesses,
+                                     n_accesses,
+                                     event_wait_list_len,
+                                     _event_wait_list,
+                                     &chunk_events[i],
+                                     enqueue_slice,
+                                     &slice);
+      if (err_code != CL_SUCCESS)
+        break;
+
+      /* start the chunk now, instead of when the whole range is enqueued */
+      gocl_queue_flush_early (queue);
+
+      done += slice.size[0];
+    }
+
+  g_free (_event_wait_list);
+
+  if (err_code == CL_SUCCESS)
+    err_code = gocl_queue_enqueue (queue,
+                                   NULL,
+                                   0,
+                                   n_chunks,
+                                   chunk_events,
+                                   &event,
+                                   enqueue_marker,
+                                   NULL);
+
+  /* on error, only the first i chunks were enqueued */
+  n_chunks = MIN (n_chunks, i);
+  for (i = 0; i < n_chunks; i++)
+    clReleaseEvent (chunk_events[i]);
+  g_free (chunk_events);
+
+  gocl_error_check_opencl_internal (err_code);
+
+  _event = gocl_event_new_from_enqueue (queue, err_code, event);
+  if (err_code == CL_SUCCESS)
+    gocl_event_set_event_wait_list (_event, event_wait_list);
+
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
+
+/**
+ * gocl_kernel_run_n:
+ * @self: The #GoclKernel
+ * @queue: A #GoclQueue to enqueue the kernel executions in
+ * @n: The number of times to run the kernel
+ * @arg_index: The index of the argument to change on each run
+ * @arg_size: The size of each value in @arg_values
+ * @arg_values: (allow-none): An array of @n values of @arg_size bytes each,
+ * or %NULL to run the kernel @n times with the same arguments
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Enqueues @n back-to-back executions of the kernel in @queue, as an
+ * iterative algorithm would do by calling gocl_kernel_run_in_queue() in a
+ * loop, but without creating a #GoclEvent for every execution. Each
+ * execution starts after the previous one finishes, also in out-of-order
+ * queues. Only the first one waits for @event_wait_list.
+ *
+ * If @arg_values is not %NULL, the argument at @arg_index is set to the i-th
+ * value of @arg_values before the i-th execution is enqueued. When this
+ * function returns, the argument holds the last value.
+ *
+ * Kernels of native programs are not supported.
+ *
+ * Returns: (transfer none): A #GoclEvent that triggers when the last
+ * execution finishes. If an error occurs, the executions enqueued before it
+ * still run, and the event is already resolved with the error.
+ **/
+GoclEvent *
+gocl_kernel_run_n (GoclKernel    *self,
+                   GoclQueue     *queue,
+                   guint          n,
+                   guint          arg_index,
+                   gsize          arg_size,
+                   gconstpointer  arg_values,
+                   GList         *event_wait_list)
+{
+  GoclKernelPrivate *priv;
+  cl_event *_event_wait_list;
+  guint event_wait_list_len;
+  GoclBufferAccess *accesses;
+  guint n_accesses;
+  Slice slice;
+  gboolean out_of_order;
+  cl_event event = NULL;
+  cl_event prev_event = NULL;
+  cl_int err_code = CL_SUCCESS;
+  guint i;
+  GoclEvent *_event;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (n > 0, NULL);
+  g_return_val_if_fail (arg_values == NULL || arg_size > 0, NULL);
+  g_return_val_if_fail (self->priv->kernel != NULL, NULL);
+
+  priv = self->priv;
+
+  init_slice (self, queue, &slice);
+
+  out_of_order =
+    (gocl_queue_get_flags (queue) & GOCL_QUEUE_FLAGS_OUT_OF_ORDER) != 0;
+
+  _event_wait_list = gocl_event_list_to_array (event_wait_list,
+                                               &event_wait_list_len);
+
+  for (i = 0; i < n; i++)
+    {
+      gboolean is_last = i == n - 1;
+
+      if (arg_values != NULL)
+        {
+          gconstpointer value;
+
+          /* the value changes on every run, so don't bother comparing it
+             with the stored one as set_arg() does */
+          value = (const guint8 *) arg_values + i * arg_size;
+          err_code = clSetKernelArg (priv->kernel, arg_index, arg_size, value);
+          if (err_code != CL_SUCCESS)
+            break;
+
+          store_arg (self, arg_index, arg_size, value, NULL);
+        }
+
+      /* the patched argument is never a buffer, so the accesses are the same
+         for all runs once it is first set */
+      if (i == 0)
+        {
+          accesses = g_newa (GoclBufferAccess, priv->args->len);
+          n_accesses = get_buffer_accesses (self, accesses);
+        }
+
+      /* in-order queues already serialize the runs, so only the last one
+         needs an event */
+      if (i == 0)
+        err_code = gocl_queue_enqueue (queue,
+                                       accesses,
+                                       n_accesses,
+                                       event_wait_list_len,
+                                       _event_wait_list,
+                                       (is_last || out_of_order) ?
+                                         &event : NULL,
+                                       enqueue_slice,
+                                       &slice);
+      else
+        err_code = gocl_queue_enqueue (queue,
+                                       accesses,
+                                       n_accesses,
+                                       out_of_order ? 1 : 0,
+                                       out_of_order ? &prev_event : NULL,
+                                       (is_last || out_of_order) ?
+                                         &event : NULL,
+                                       enqueue_slice,
+                                       &slice);
+      if (err_code != CL_SUCCESS)
+        break;
+
+      if (prev_event != NULL)
+        clReleaseEvent (prev_event);
+      prev_event = is_last ? NULL : event;
     }
 
+  g_free (_event_wait_list);
+
+  if (prev_event != NULL)
+    clReleaseEvent (prev_event);
+
+  gocl_error_check_opencl_internal (err_code);
+
+  _event = gocl_event_new_from_enqueue (queue, err_code, event);
+  if (err_code == CL_SUCCESS)
+    gocl_event_set_event_wait_list (_event, event_wait_list);
+
   gocl_event_idle_unref (_event);
 
   return _event;
 }
 
 /**
- * gocl_kernel_set_work_dimension:
+ * gocl_kernel_run_in_devices:
  * @self: The #GoclKernel
- * @work_dim: The work dimension
+ * @devices: (element-type Gocl.Device) (allow-none): List of #GoclDevice
+ * objects to run the kernel on, or %NULL for all the devices of the context
+ * of the program
+ * @policy: A value from #GoclSplitPolicy
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
  *
- * Sets the work dimension (1, 2, 3) to use when executing the kernel.
+ * Runs the kernel on several devices at once. The first dimension of the
+ * global index space is split in one part per device, sized according to
+ * @policy, and each part is enqueued in the default queue of its device (see
+ * gocl_device_get_default_queue()) with the corresponding global work offset.
+ *
+ * When @devices is given, each part is ordered after the commands previously
+ * enqueued in the default queue of its device, like any other command in that
+ * queue. When @devices is %NULL, the kernel uses #GoclDevice objects of its
+ * own, whose queues are not those of the devices of the application, so
+ * @event_wait_list must include the events of all the commands the kernel
+ * depends on, for example the writes to its input buffers.
+ *
+ * If a local work size is set, the parts are a multiple of it, and it must be
+ * valid on every device. The automatic local work size modes (see
+ * gocl_kernel_set_auto_local_work_size()) are not applied. A global work size
+ * must be set. The program must have been built for all the devices, which
+ * is the case when gocl_program_build_sync() is used.
+ *
+ * The time each part takes is measured, and used by
+ * %GOCL_SPLIT_POLICY_THROUGHPUT to balance later executions. The time is
+ * taken from the device when the queue was created with
+ * %GOCL_QUEUE_FLAGS_PROFILING, and otherwise from the host, which also counts
+ * the time the part waited in the queue. Kernels of native programs run on
+ * host threads, as with gocl_kernel_run_in_device().
+ *
+ * Returns: (transfer none): A #GoclEvent that triggers when all the parts
+ * finish, or an event already failed with the error if any of them cannot be
+ * enqueued. %NULL if there are no devices.
  **/
-void
-gocl_kernel_set_work_dimension (GoclKernel *self, guint8 work_dim)
+GoclEvent *
+gocl_kernel_run_in_devices (GoclKernel      *self,
+                            GList           *devices,
+                            GoclSplitPolicy  policy,
+                            GList           *event_wait_list)
 {
-  g_return_if_fail (GOCL_IS_KERNEL (self));
-  g_return_if_fail (work_dim > 0 && work_dim <= 3);
+  GoclKernelPrivate *priv;
+  GPtrArray *device_array;
+  gdouble *weights;
+  gdouble total_weight = 0.0;
+  gdouble acc_weight = 0.0;
+  cl_event *_event_wait_list;
+  guint event_wait_list_len;
+  GoclBufferAccess *accesses;
+  guint n_accesses;
+  Slice slice;
+  gsize granularity;
+  gsize n_units;
+  gsize done_units = 0;
+  GList *events = NULL;
+  GList *node;
+  GoclEvent *_event = NULL;
+  GoclEvent *failed_event = NULL;
+  guint i;
 
-  self->priv->work_dim = work_dim;
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+  g_return_val_if_fail (self->priv->global_work_size[0] > 0, NULL);
+
+  priv = self->priv;
+
+  if (priv->native_func != NULL)
+    return host_event_to_caller (run_on_host_list (self, event_wait_list));
+
+  if (devices != NULL)
+    {
+      device_array = g_ptr_array_new ();
+      for (node = devices; node != NULL; node = node->next)
+        g_ptr_array_add (device_array, GOCL_DEVICE (node->data));
+    }
+  else
+    {
+      device_array = g_ptr_array_ref (get_split_devices (self));
+    }
+
+  if (device_array->len == 0)
+    {
+      g_set_error (gocl_error_prepare (),
+                   GOCL_OPENCL_ERROR,
+                   CL_DEVICE_NOT_FOUND,
+                   "The context of kernel '%s' has no devices",
+                   priv->name);
+      g_ptr_array_unref (device_array);
+      return NULL;
+    }
+
+  weights = g_newa (gdouble, device_array->len);
+  get_split_weights (self, device_array, policy, weights);
+  for (i = 0; i < device_array->len; i++)
+    total_weight += weights[i];
+
+  granularity = MAX (priv->local_work_size[0], 1);
+  n_units = (priv->global_work_size[0] + granularity - 1) / granularity;
+
+  accesses = g_newa (GoclBufferAccess, priv->args->len);
+  n_accesses = get_buffer_accesses (self, accesses);
+
+  _event_wait_list = gocl_event_list_to_array (event_wait_list,
+                                               &event_wait_list_len);
+
+  slice.kernel = self;
+  memcpy (slice.offset, priv->global_work_offset, sizeof (WorkSize));
+  memcpy (slice.size, priv->global_work_size, sizeof (WorkSize));
+  memcpy (slice.local, priv->local_work_size, sizeof (WorkSize));
+
+  for (i = 0; i < device_array->len; i++)
+    {
+      GoclDevice *device = device_array->pdata[i];
+      GoclQueue *queue;
+      SplitPart *part;
+      gsize end_units;
+      gsize start;
+      cl_event event = NULL;
+      cl_int err_code;
+
+      /* rounding the accumulated share keeps the parts contiguous, and the
+         last one ends exactly at the end of the range */
+      acc_weight += weights[i];
+      if (i == device_array->len - 1)
+        end_units = n_units;
+      else
+        end_units = (gsize) (n_units * (acc_weight / total_weight) + 0.5);
+
+      if (end_units <= done_units)
+        continue;
+
+      /* the rest of the range would not run, so the whole execution fails */
+      queue = gocl_device_get_default_queue (device);
+      if (queue == NULL)
+        {
+          failed_event = gocl_event_new_from_enqueue (NULL,
+                                                      CL_INVALID_COMMAND_QUEUE,
+                                                      NULL);
+          break;
+        }
+
+      start = done_units * granularity;
+      slice.offset[0] = priv->global_work_offset[0] + start;
+      slice.size[0] = MIN (end_units * granularity,
+                           priv->global_work_size[0]) - start;
+
+      part = g_slice_new (SplitPart);
+      part->kernel = g_object_ref (self);
+      part->device_id = gocl_device_get_id (device);
+      part->work_items = slice.size[0];
+      part->start_time = g_get_monotonic_time ();
+
+      err_code = gocl_queue_enqueue (queue,
+                                     accesses,
+                                     n_accesses,
+                                     event_wait_list_len,
+                                     _event_wait_list,
+                                     &event,
+                                     enqueue_slice,
+                                     &slice);
+
+      _event = gocl_event_new_from_enqueue (queue, err_code, event);
+
+      /* a failed part fails the whole execution right away */
+      if (gocl_error_check_opencl_internal (err_code))
+        {
+          failed_event = _event;
+          g_object_unref (part->kernel);
+          g_slice_free (SplitPart, part);
+          break;
+        }
+
+      events = g_list_prepend (events, _event);
+
+      gocl_event_set_event_wait_list (_event, event_wait_list);
+      gocl_event_then_full (_event,
+                            GOCL_EVENT_DISPATCH_DIRECT,
+                            split_part_on_complete,
+                            part);
+
+      /* start this part while the rest are being enqueued */
+      gocl_queue_flush_early (queue);
+
+      done_units = end_units;
+    }
+
+  g_free (_event_wait_list);
+  g_ptr_array_unref (device_array);
+
+  /* on failure, the event of the failed part is returned as is, already
+     resolved with the error. The parts enqueued before it still run, and
+     are kept alive by their pending notifications */
+  if (failed_event != NULL)
+    {
+      g_list_free_full (events, g_object_unref);
+      gocl_event_idle_unref (failed_event);
+
+      return failed_event;
+    }
+
+  events = g_list_reverse (events);
+  _event = gocl_event_all (events);
+
+  /* the aggregate event holds its own references to the parts */
+  g_list_free_full (events, g_object_unref);
+
+  return _event;
 }
 
 /**
- * gocl_kernel_set_global_work_size:
+ * gocl_kernel_get_num_arguments:
  * @self: The #GoclKernel
- * @size1: global work size for the first dimension
- * @size2: global work size for the second dimension
- * @size3: global work size for the third dimension
  *
- * Sets the global work sizes to use when executing the kernel, corresponding
- * to the first, second, and third dimensions, respectively. By default, the
- * sizes are all zeros.
+ * Retrieves the number of arguments of the kernel function.
  *
- * If the @size1 value is zero, it means no global work size is specified and
- * %NULL will be used when enqueuing the kernel.
+ * The metadata of the arguments is queried from the OpenCL implementation the
+ * first time it is needed, and cached for the lifetime of the kernel. It is
+ * only available for programs built with gocl_program_build_sync() or
+ * gocl_program_build(), which pass the "-cl-kernel-arg-info" option that
+ * some implementations require for it.
+ *
+ * Returns: The number of arguments, or 0 on error
  **/
-void
-gocl_kernel_set_global_work_size (GoclKernel *self,
-                                  gsize       size1,
-                                  gsize       size2,
-                                  gsize       size3)
+guint
+gocl_kernel_get_num_arguments (GoclKernel *self)
 {
-  g_return_if_fail (GOCL_IS_KERNEL (self));
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), 0);
 
-  self->priv->global_work_size[0] = size1;
-  self->priv->global_work_size[1] = size2;
-  self->priv->global_work_size[2] = size3;
+  if (! load_arg_info (self))
+    return 0;
+
+  return self->priv->n_args;
 }
 
 /**
- * gocl_kernel_set_local_work_size:
+ * gocl_kernel_get_argument_index:
  * @self: The #GoclKernel
- * @size1: local work size for the first dimension
- * @size2: local work size for the second dimension
- * @size3: local work size for the third dimension
+ * @name: The name of an argument
  *
- * Sets the local work sizes to use when executing the kernel, corresponding
- * to the first, second, and third dimensions, respectively. By default, the
- * sizes are all zeros.
+ * Retrieves the index of the argument called @name in the kernel function.
  *
- * If the @size1 value is zero, it means no local work size is specified and
- * %NULL will be used when enqueuing the kernel.
+ * Returns: The index of the argument, or -1 if there is no such argument or
+ * on error
  **/
-void
-gocl_kernel_set_local_work_size (GoclKernel *self,
-                                 gsize       size1,
-                                 gsize       size2,
-                                 gsize       size3)
+gint
+gocl_kernel_get_argument_index (GoclKernel *self, const gchar *name)
 {
-  g_return_if_fail (GOCL_IS_KERNEL (self));
+  guint index;
 
-  self->priv->local_work_size[0] = size1;
-  self->priv->local_work_size[1] = size2;
-  self->priv->local_work_size[2] = size3;
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), -1);
+  g_return_val_if_fail (name != NULL, -1);
+
+  if (lookup_arg_info (self, name, &index) == NULL)
+    return -1;
+
+  return index;
+}
+
+/**
+ * gocl_kernel_get_argument_name:
+ * @self: The #GoclKernel
+ * @index: The index of an argument
+ *
+ * Retrieves the name of the argument at @index in the kernel function.
+ *
+ * Returns: (transfer none): The name of the argument, or %NULL on error
+ **/
+const gchar *
+gocl_kernel_get_argument_name (GoclKernel *self, guint index)
+{
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+
+  if (! load_arg_info (self))
+    return NULL;
+
+  g_return_val_if_fail (index < self->priv->n_args, NULL);
+
+  return self->priv->arg_info[index].name;
+}
+
+/**
+ * gocl_kernel_get_argument_type_name:
+ * @self: The #GoclKernel
+ * @index: The index of an argument
+ *
+ * Retrieves the name of the type of the argument at @index, as written in
+ * the kernel source, like "float4" or "int*".
+ *
+ * Returns: (transfer none): The type name of the argument, or %NULL on error
+ **/
+const gchar *
+gocl_kernel_get_argument_type_name (GoclKernel *self, guint index)
+{
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+
+  if (! load_arg_info (self))
+    return NULL;
+
+  g_return_val_if_fail (index < self->priv->n_args, NULL);
+
+  return self->priv->arg_info[index].type_name;
+}
+
+/**
+ * gocl_kernel_get_argument_address_qualifier:
+ * @self: The #GoclKernel
+ * @index: The index of an argument
+ *
+ * Retrieves the address space of the argument at @index.
+ *
+ * Returns: A value from #GoclAddressQualifier.
+ * %GOCL_ADDRESS_QUALIFIER_PRIVATE is returned on error
+ **/
+GoclAddressQualifier
+gocl_kernel_get_argument_address_qualifier (GoclKernel *self, guint index)
+{
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), GOCL_ADDRESS_QUALIFIER_PRIVATE);
+
+  if (! load_arg_info (self))
+    return GOCL_ADDRESS_QUALIFIER_PRIVATE;
+
+  g_return_val_if_fail (index < self->priv->n_args,
+                        GOCL_ADDRESS_QUALIFIER_PRIVATE);
+
+  return self->priv->arg_info[index].address;
+}
+
+/**
+ * gocl_kernel_set_argument_by_name:
+ * @self: The #GoclKernel
+ * @name: The name of the argument in the kernel function
+ * @size: The size of @buffer, in bytes
+ * @buffer: (allow-none): A pointer to an arbitrary block of memory
+ *
+ * Sets the value of the kernel argument called @name, like
+ * gocl_kernel_set_argument() does by index.
+ *
+ * The value is checked against the declaration of the argument before
+ * setting it: @size must match the size of scalar and vector types, and
+ * arguments in local memory only accept a %NULL @buffer.
+ *
+ * This, and the other methods that set arguments by name, need the argument
+ * metadata that gocl_program_build_sync() makes available (see
+ * gocl_kernel_get_num_arguments()).
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_argument_by_name (GoclKernel      *self,
+                                  const gchar     *name,
+                                  gsize            size,
+                                  const gpointer  *buffer)
+{
+  const ArgInfo *info;
+  guint index;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (name != NULL, FALSE);
+
+  info = lookup_arg_info (self, name, &index);
+  if (info == NULL || ! check_arg_value (self, info, size, buffer))
+    return FALSE;
+
+  return gocl_kernel_set_argument (self, index, size, buffer);
+}
+
+/**
+ * gocl_kernel_set_argument_int32_by_name:
+ * @self: The #GoclKernel
+ * @name: The name of the argument in the kernel function
+ * @num_elements: The number of int32 elements in @buffer
+ * @buffer: (array length=num_elements) (element-type guint32): Array of int32
+ * values
+ *
+ * Sets the value of the kernel argument called @name, as an array of int32.
+ * The argument must be declared as an int or uint scalar or vector with
+ * @num_elements components.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_argument_int32_by_name (GoclKernel   *self,
+                                        const gchar  *name,
+                                        gsize         num_elements,
+                                        gint32       *buffer)
+{
+  const ArgInfo *info;
+  guint index;
+  gsize size = sizeof (cl_int) * num_elements;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (name != NULL, FALSE);
+
+  info = lookup_arg_info (self, name, &index);
+  if (info == NULL ||
+      ! check_type_name (self, info, "int", "uint") ||
+      ! check_arg_value (self, info, size, buffer))
+    {
+      return FALSE;
+    }
+
+  return gocl_kernel_set_argument (self, index, size, (const gpointer) buffer);
+}
+
+/**
+ * gocl_kernel_set_argument_float_by_name:
+ * @self: The #GoclKernel
+ * @name: The name of the argument in the kernel function
+ * @num_elements: The number of float elements in @buffer
+ * @buffer: (array length=num_elements) (element-type gfloat): Array of float
+ * values
+ *
+ * Sets the value of the kernel argument called @name, as an array of floats.
+ * The argument must be declared as a float scalar or vector with
+ * @num_elements components.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_argument_float_by_name (GoclKernel   *self,
+                                        const gchar  *name,
+                                        gsize         num_elements,
+                                        gfloat       *buffer)
+{
+  const ArgInfo *info;
+  guint index;
+  gsize size = sizeof (cl_float) * num_elements;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (name != NULL, FALSE);
+
+  info = lookup_arg_info (self, name, &index);
+  if (info == NULL ||
+      ! check_type_name (self, info, "float", NULL) ||
+      ! check_arg_value (self, info, size, buffer))
+    {
+      return FALSE;
+    }
+
+  return gocl_kernel_set_argument (self, index, size, (const gpointer) buffer);
+}
+
+/**
+ * gocl_kernel_set_argument_buffer_by_name:
+ * @self: The #GoclKernel
+ * @name: The name of the argument in the kernel function
+ * @buffer: A #GoclBuffer
+ *
+ * Sets the value of the kernel argument called @name, as a buffer object.
+ * The argument must be declared in global or constant memory.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_argument_buffer_by_name (GoclKernel   *self,
+                                         const gchar  *name,
+                                         GoclBuffer   *buffer)
+{
+  const ArgInfo *info;
+  guint index;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (name != NULL, FALSE);
+  g_return_val_if_fail (GOCL_IS_BUFFER (buffer), FALSE);
+
+  info = lookup_arg_info (self, name, &index);
+  if (info == NULL)
+    return FALSE;
+
+  if (info->address != CL_KERNEL_ARG_ADDRESS_GLOBAL &&
+      info->address != CL_KERNEL_ARG_ADDRESS_CONSTANT)
+    {
+      g_set_error (gocl_error_prepare (),
+                   GOCL_OPENCL_ERROR,
+                   CL_INVALID_ARG_VALUE,
+                   "Argument '%s' of kernel '%s' has type '%s', which is "
+                   "not a buffer",
+                   info->name,
+                   self->priv->name,
+                   info->type_name);
+      return FALSE;
+    }
+
+  return gocl_kernel_set_argument_buffer (self, index, buffer);
+}
+
+/**
+ * gocl_kernel_clone:
+ * @self: The #GoclKernel
+ *
+ * Creates a new kernel for the same program and function as this kernel,
+ * with a copy of all the arguments, work sizes and work offsets set so far,
+ * and the same automatic local work size settings (see
+ * gocl_kernel_set_autotune() and gocl_kernel_set_auto_local_work_size()).
+ *
+ * The arguments of a kernel are shared by everyone using it, so a
+ * #GoclKernel must not be configured and run from several threads at the
+ * same time. The new kernel is independent from @self, so each one can be
+ * configured and run from a different thread without any locking.
+ *
+ * Returns: (transfer full): A new #GoclKernel, or %NULL on error
+ **/
+GoclKernel *
+gocl_kernel_clone (GoclKernel *self)
+{
+  GoclKernel *clone;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+
+  clone = gocl_program_get_kernel (self->priv->program, self->priv->name);
+  if (clone == NULL)
+    return NULL;
+
+  for (i = 0; i < self->priv->args->len; i++)
+    {
+      KernelArg *arg;
+      gconstpointer value;
+
+      arg = &g_array_index (self->priv->args, KernelArg, i);
+      if (! arg->set)
+        continue;
+
+      value = get_arg_value (arg);
+
+      if (! set_arg (clone, i, arg->size, value, arg->buffer))
+        {
+          g_object_unref (clone);
+          return NULL;
+        }
+    }
+
+  clone->priv->work_dim = self->priv->work_dim;
+  memcpy (clone->priv->global_work_offset,
+          self->priv->global_work_offset,
+          sizeof (WorkSize));
+  memcpy (clone->priv->global_work_size,
+          self->priv->global_work_size,
+          sizeof (WorkSize));
+  memcpy (clone->priv->local_work_size,
+          self->priv->local_work_size,
+          sizeof (WorkSize));
+  clone->priv->autotune = self->priv->autotune;
+  clone->priv->auto_local_size = self->priv->auto_local_size;
+
+  return clone;
+}
+
+/**
+ * gocl_kernel_get_thread_instance:
+ * @self: The #GoclKernel
+ *
+ * Retrieves the instance of this kernel that belongs to the calling thread.
+ * The first time a thread calls this method, a clone of @self is created
+ * with gocl_kernel_clone(), capturing the arguments and work sizes set at
+ * that moment. Later calls from the same thread return the same instance,
+ * which is only used by that thread and can therefore be configured and run
+ * without any locking.
+ *
+ * An instance is released when its thread exits. Instances of kernels that
+ * have been finalized are released the next time the thread needs a new
+ * instance, or when it exits.
+ *
+ * Returns: (transfer none): The #GoclKernel instance of the calling thread,
+ * or %NULL on error
+ **/
+GoclKernel *
+gocl_kernel_get_thread_instance (GoclKernel *self)
+{
+  GHashTable *instances;
+  ThreadInstance *thread_instance;
+  GoclKernel *instance;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+
+  instances = g_private_get (&thread_instances);
+  if (instances == NULL)
+    {
+      instances = g_hash_table_new_full (g_direct_hash,
+                                         g_direct_equal,
+                                         NULL,
+                                         thread_instance_free);
+      g_private_set (&thread_instances, instances);
+    }
+
+  thread_instance = g_hash_table_lookup (instances, self);
+  if (thread_instance != NULL)
+    {
+      GoclKernel *kernel;
+
+      kernel = g_weak_ref_get (&thread_instance->kernel);
+      if (kernel != NULL)
+        g_object_unref (kernel);
+
+      if (kernel == self)
+        return thread_instance->instance;
+    }
+
+  g_hash_table_foreach_remove (instances, thread_instance_is_stale, NULL);
+
+  instance = gocl_kernel_clone (self);
+  if (instance == NULL)
+    return NULL;
+
+  thread_instance = g_slice_new (ThreadInstance);
+  g_weak_ref_init (&thread_instance->kernel, self);
+  thread_instance->instance = instance;
+
+  g_hash_table_replace (instances, self, thread_instance);
+
+  return instance;
 }
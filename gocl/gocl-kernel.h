@@ -23,6 +23,7 @@
 #define __GOCL_KERNEL_H__
 
 #include <glib-object.h>
+#include <gio/gio.h>
 
 #include "gocl-device.h"
 #include "gocl-event.h"
@@ -52,8 +53,16 @@ struct _GoclKernelClass
   GObjectClass parent_class;
 };
 
+typedef void (* GoclNativeKernelFunc) (GoclKernel  *kernel,
+                                       const gsize *global_work_offset,
+                                       const gsize *global_work_size,
+                                       gpointer     user_data);
+
 GType                  gocl_kernel_get_type                   (void) G_GNUC_CONST;
 
+GoclKernel *           gocl_kernel_clone                      (GoclKernel *self);
+GoclKernel *           gocl_kernel_get_thread_instance        (GoclKernel *self);
+
 gboolean               gocl_kernel_set_argument               (GoclKernel      *self,
                                                                guint            index,
                                                                gsize            size,
@@ -69,6 +78,40 @@ gboolean               gocl_kernel_set_argument_float         (GoclKernel  *self
 gboolean               gocl_kernel_set_argument_buffer        (GoclKernel  *self,
                                                                guint        index,
                                                                GoclBuffer  *buffer);
+gboolean               gocl_kernel_set_arguments_from_variant (GoclKernel  *self,
+                                                               guint        first_index,
+                                                               GVariant    *arguments);
+gconstpointer          gocl_kernel_get_argument_value         (GoclKernel  *self,
+                                                               guint        index,
+                                                               gsize       *size);
+
+guint                  gocl_kernel_get_num_arguments          (GoclKernel *self);
+gint                   gocl_kernel_get_argument_index         (GoclKernel  *self,
+                                                               const gchar *name);
+const gchar *          gocl_kernel_get_argument_name          (GoclKernel *self,
+                                                               guint       index);
+const gchar *          gocl_kernel_get_argument_type_name     (GoclKernel *self,
+                                                               guint       index);
+GoclAddressQualifier   gocl_kernel_get_argument_address_qualifier
+                                                              (GoclKernel *self,
+                                                               guint       index);
+
+gboolean               gocl_kernel_set_argument_by_name       (GoclKernel      *self,
+                                                               const gchar     *name,
+                                                               gsize            size,
+                                                               const gpointer  *buffer);
+gboolean               gocl_kernel_set_argument_int32_by_name (GoclKernel   *self,
+                                                               const gchar  *name,
+                                                               gsize         num_elements,
+                                                               gint32       *buffer);
+gboolean               gocl_kernel_set_argument_float_by_name (GoclKernel   *self,
+                                                               const gchar  *name,
+                                                               gsize         num_elements,
+                                                               gfloat       *buffer);
+gboolean               gocl_kernel_set_argument_buffer_by_name
+                                                              (GoclKernel   *self,
+                                                               const gchar  *name,
+                                                               GoclBuffer   *buffer);
 
 gboolean               gocl_kernel_run_in_device_sync         (GoclKernel  *self,
                                                                GoclDevice  *device,
@@ -76,6 +119,44 @@ gboolean               gocl_kernel_run_in_device_sync         (GoclKernel  *self
 GoclEvent *            gocl_kernel_run_in_device              (GoclKernel  *self,
                                                                GoclDevice  *device,
                                                                GList       *event_wait_list);
+gboolean               gocl_kernel_run_in_queue_sync          (GoclKernel  *self,
+                                                               GoclQueue   *queue,
+                                                               GList       *event_wait_list);
+GoclEvent *            gocl_kernel_run_in_queue               (GoclKernel  *self,
+                                                               GoclQueue   *queue,
+                                                               GList       *event_wait_list);
+GoclEvent *            gocl_kernel_run_in_queue_chunked       (GoclKernel  *self,
+                                                               GoclQueue   *queue,
+                                                               gsize        chunk_size,
+                                                               GList       *event_wait_list);
+GoclEvent *            gocl_kernel_run_n                      (GoclKernel    *self,
+                                                               GoclQueue     *queue,
+                                                               guint          n,
+                                                               guint          arg_index,
+                                                               gsize          arg_size,
+                                                               gconstpointer  arg_values,
+                                                               GList         *event_wait_list);
+GoclEvent *            gocl_kernel_run_in_devices             (GoclKernel      *self,
+                                                               GList           *devices,
+                                                               GoclSplitPolicy  policy,
+                                                               GList           *event_wait_list);
+GoclEvent *            gocl_kernel_run_in_device_v            (GoclKernel  *self,
+                                                               GoclDevice  *device,
+                                                               GoclEvent  **event_wait_list,
+                                                               guint        event_wait_list_len);
+gboolean               gocl_kernel_run_in_device_detached     (GoclKernel  *self,
+                                                               GoclDevice  *device,
+                                                               GoclEvent  **event_wait_list,
+                                                               guint        event_wait_list_len);
+void                   gocl_kernel_run_in_device_async        (GoclKernel          *self,
+                                                               GoclDevice          *device,
+                                                               GList               *event_wait_list,
+                                                               GCancellable        *cancellable,
+                                                               GAsyncReadyCallback  callback,
+                                                               gpointer             user_data);
+gboolean               gocl_kernel_run_in_device_finish       (GoclKernel    *self,
+                                                               GAsyncResult  *result,
+                                                               GError       **error);
 
 void                   gocl_kernel_set_work_dimension         (GoclKernel *self,
                                                                guint8      work_dim);
@@ -83,11 +164,32 @@ void                   gocl_kernel_set_global_work_size       (GoclKernel *self,
                                                                gsize       size1,
                                                                gsize       size2,
                                                                gsize       size3);
+void                   gocl_kernel_set_global_work_offset     (GoclKernel *self,
+                                                               gsize       offset1,
+                                                               gsize       offset2,
+                                                               gsize       offset3);
 void                   gocl_kernel_set_local_work_size        (GoclKernel *self,
                                                                gsize       size1,
                                                                gsize       size2,
                                                                gsize       size3);
 
+gboolean               gocl_kernel_tune_local_work_size_sync  (GoclKernel *self,
+                                                               GoclDevice *device);
+void                   gocl_kernel_set_autotune               (GoclKernel *self,
+                                                               gboolean    autotune);
+void                   gocl_kernel_set_auto_local_work_size   (GoclKernel *self,
+                                                               gboolean    auto_size);
+
+gsize                  gocl_kernel_get_work_group_size        (GoclKernel *self,
+                                                               GoclDevice *device);
+gsize                  gocl_kernel_get_preferred_work_group_size_multiple
+                                                              (GoclKernel *self,
+                                                               GoclDevice *device);
+guint64                gocl_kernel_get_local_mem_size         (GoclKernel *self,
+                                                               GoclDevice *device);
+guint64                gocl_kernel_get_private_mem_size       (GoclKernel *self,
+                                                               GoclDevice *device);
+
 G_END_DECLS
 
 #endif /* __GOCL_KERNEL_H__ */
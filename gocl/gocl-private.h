@@ -23,6 +23,7 @@
 #define __GOCL_PRIVATE_H__
 
 #include <glib.h>
+#include <gio/gio.h>
 #include <CL/opencl.h>
 
 #include "gocl-context.h"
@@ -35,17 +36,88 @@
 G_BEGIN_DECLS
 
 cl_context        gocl_context_get_context         (GoclContext *self);
+GoclContext *     gocl_context_new_for_sub_devices (GoclContext        *self,
+                                                    const cl_device_id *devices,
+                                                    guint               num_devices);
 
 cl_program        gocl_program_get_program         (GoclProgram *self);
+const gchar *     gocl_program_get_source_hash     (GoclProgram *self);
+GoclNativeKernelFunc
+                  gocl_program_get_native_kernel   (GoclProgram  *self,
+                                                    const gchar  *kernel_name,
+                                                    gpointer     *user_data);
 
 cl_kernel         gocl_kernel_get_kernel           (GoclKernel *self);
+cl_kernel         gocl_kernel_dup_kernel           (GoclKernel *self);
+void              gocl_kernel_get_work_size        (GoclKernel *self,
+                                                    guint8     *work_dim,
+                                                    gsize      *global_work_offset,
+                                                    gsize      *global_work_size,
+                                                    gsize      *local_work_size);
+GoclBuffer *      gocl_kernel_get_argument_buffer  (GoclKernel *self,
+                                                    guint       index);
+guint             gocl_kernel_get_num_arguments_set (GoclKernel *self);
 
 cl_mem            gocl_buffer_get_buffer           (GoclBuffer *self);
 
 cl_command_queue  gocl_queue_get_queue             (GoclQueue *self);
+GoclEvent *       gocl_queue_take_pooled_event     (GoclQueue *self);
+gboolean          gocl_queue_recycle_event         (GoclQueue *self,
+                                                    GoclEvent *event);
+void              gocl_queue_add_pending_commands  (GoclQueue *self,
+                                                    gint       delta);
+guint             gocl_queue_get_pending_commands  (GoclQueue *self);
+gboolean          gocl_queue_flush_early           (GoclQueue *self);
 
+GoclEvent *       gocl_event_new                   (GoclQueue *queue,
+                                                    cl_event   event);
+GoclEvent *       gocl_event_new_from_enqueue      (GoclQueue *queue,
+                                                    cl_int     err_code,
+                                                    cl_event   event);
 cl_event          gocl_event_get_event             (GoclEvent *self);
 
+/* wait lists up to this size are converted without allocating memory */
+#define GOCL_EVENT_INLINE_WAIT_LIST_SIZE 16
+
+cl_event *        gocl_event_array_to_cl_array     (GoclEvent **events,
+                                                    guint       len,
+                                                    cl_event   *inline_array);
+
+typedef cl_int (* GoclEventEnqueueFunc) (cl_command_queue  queue,
+                                         guint             event_wait_list_len,
+                                         const cl_event   *event_wait_list,
+                                         cl_event         *out_event,
+                                         gpointer          user_data);
+
+/* a buffer accessed by an enqueued command, for hazard tracking and
+   auto-flush accounting; transfer_size is the number of bytes moved between
+   host and device, 0 for kernel executions */
+typedef struct
+{
+  GoclBuffer *buffer;
+  gboolean write;
+  gsize transfer_size;
+} GoclBufferAccess;
+
+GMainContext *    gocl_event_get_main_context      (void);
+
+cl_int            gocl_queue_enqueue               (GoclQueue              *self,
+                                                    const GoclBufferAccess *accesses,
+                                                    guint                   n_accesses,
+                                                    guint                   event_wait_list_len,
+                                                    const cl_event         *event_wait_list,
+                                                    cl_event               *out_event,
+                                                    GoclEventEnqueueFunc    enqueue_func,
+                                                    gpointer                user_data);
+
+void              gocl_event_enqueue_task          (GTask                  *task,
+                                                    GoclQueue              *queue,
+                                                    GList                  *event_wait_list,
+                                                    const GoclBufferAccess *accesses,
+                                                    guint                   n_accesses,
+                                                    GoclEventEnqueueFunc    enqueue_func,
+                                                    gpointer                user_data);
+
 
 gboolean          gocl_error_check_opencl          (cl_int   err_code,
                                                     GError **error);
@@ -42,6 +42,13 @@
  *
  * Once a program is successfully built, kernels can be obtained from it using
  * gocl_program_get_kernel() method.
+ *
+ * Kernels can also have a native C implementation, registered with
+ * gocl_program_add_native_kernel(). A program created with
+ * gocl_program_new_native() contains no OpenCL code at all, and runs the
+ * native implementations of its kernels on a pool of host threads. Since it
+ * does not need an OpenCL implementation, it serves as a fallback on systems
+ * where no context can be created.
  **/
 
 /**
@@ -58,6 +65,9 @@
 #include "gocl-private.h"
 #include "gocl-error.h"
 
+/* makes the argument metadata of the kernels available */
+#define KERNEL_ARG_INFO_OPTION "-cl-kernel-arg-info"
+
 struct _GoclProgramPrivate
 {
   cl_program program;
@@ -65,8 +75,20 @@ struct _GoclProgramPrivate
   GoclContext *context;
 
   gboolean building;
+
+  gchar *source_hash;
+
+  GHashTable *native_kernels;
 };
 
+/* a native implementation of a kernel */
+typedef struct
+{
+  GoclNativeKernelFunc func;
+  gpointer user_data;
+  GDestroyNotify notify;
+} NativeKernel;
+
 /* properties */
 enum
 {
@@ -125,6 +147,8 @@ gocl_program_init (GoclProgram *self)
   self->priv = priv = GOCL_PROGRAM_GET_PRIVATE (self);
 
   priv->building = FALSE;
+  priv->source_hash = NULL;
+  priv->native_kernels = NULL;
 }
 
 static void
@@ -138,9 +162,16 @@ gocl_program_finalize (GObject *obj)
 {
   GoclProgram *self = GOCL_PROGRAM (obj);
 
-  g_object_unref (self->priv->context);
+  if (self->priv->context != NULL)
+    g_object_unref (self->priv->context);
+
+  g_free (self->priv->source_hash);
 
-  clReleaseProgram (self->priv->program);
+  if (self->priv->native_kernels != NULL)
+    g_hash_table_unref (self->priv->native_kernels);
+
+  if (self->priv->program != NULL)
+    clReleaseProgram (self->priv->program);
 
   G_OBJECT_CLASS (gocl_program_parent_class)->finalize (obj);
 }
@@ -212,6 +243,17 @@ build_in_thread (GSimpleAsyncResult *res,
   self->priv->building = FALSE;
 }
 
+static void
+free_native_kernel (gpointer data)
+{
+  NativeKernel *native = data;
+
+  if (native->notify != NULL)
+    native->notify (native->user_data);
+
+  g_slice_free (NativeKernel, native);
+}
+
 /* public */
 
 /**
@@ -232,6 +274,8 @@ gocl_program_new (GoclContext  *context,
 {
   GoclProgram *self;
   cl_int err_code;
+  GChecksum *checksum;
+  guint i;
 
   g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
   g_return_val_if_fail (sources != NULL, NULL);
@@ -243,6 +287,14 @@ gocl_program_new (GoclContext  *context,
   if (num_sources < 1)
     num_sources = g_strv_length ((gchar **) sources);
 
+  /* the sources are not kept, only a digest that identifies them */
+  checksum = g_checksum_new (G_CHECKSUM_SHA1);
+  for (i = 0; i < num_sources; i++)
+    g_checksum_update (checksum, (const guchar *) sources[i],
+                       strlen (sources[i]) + 1);
+  self->priv->source_hash = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+
   self->priv->program =
     clCreateProgramWithSource (gocl_context_get_context (context),
                                num_sources,
@@ -255,6 +307,29 @@ gocl_program_new (GoclContext  *context,
   return self;
 }
 
+/**
+ * gocl_program_new_native:
+ *
+ * Creates and returns a new #GoclProgram that contains no OpenCL code. Its
+ * kernels are the native implementations registered with
+ * gocl_program_add_native_kernel(), which run on a pool of host threads when
+ * the kernel is executed with gocl_kernel_run_in_device() and similar methods.
+ * The index space is split in chunks that idle threads pick up until none is
+ * left, so threads that finish early take over the remaining work.
+ *
+ * A native program does not need an OpenCL implementation, nor a
+ * #GoclContext, so it allows for the same code to keep running on systems
+ * where gocl_context_get_default_cpu_sync() and the like return %NULL.
+ * Building a native program always succeeds.
+ *
+ * Returns: (transfer full): A newly created #GoclProgram
+ **/
+GoclProgram *
+gocl_program_new_native (void)
+{
+  return g_object_new (GOCL_TYPE_PROGRAM, NULL);
+}
+
 /**
  * gocl_program_new_from_file_sync:
  * @context: The #GoclContext
@@ -308,14 +383,69 @@ gocl_program_get_program (GoclProgram *self)
   return self->priv->program;
 }
 
+/**
+ * gocl_program_get_source_hash: (skip)
+ * @self: The #GoclProgram
+ *
+ * Retrieves a SHA1 digest of the source code the program was created from, as
+ * an hexadecimal string. Programs created from the same sources have the same
+ * digest.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: (transfer none): The source digest of the program
+ **/
+const gchar *
+gocl_program_get_source_hash (GoclProgram *self)
+{
+  g_return_val_if_fail (GOCL_IS_PROGRAM (self), NULL);
+
+  return self->priv->source_hash;
+}
+
+/**
+ * gocl_program_get_native_kernel: (skip)
+ * @self: The #GoclProgram
+ * @kernel_name: The name of the kernel
+ * @user_data: (out): Location for the data registered with the implementation
+ *
+ * Retrieves the native implementation registered for the kernel named
+ * @kernel_name with gocl_program_add_native_kernel().
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: The native implementation of the kernel, or %NULL if there is none
+ **/
+GoclNativeKernelFunc
+gocl_program_get_native_kernel (GoclProgram  *self,
+                                const gchar  *kernel_name,
+                                gpointer     *user_data)
+{
+  NativeKernel *native;
+
+  g_return_val_if_fail (GOCL_IS_PROGRAM (self), NULL);
+
+  if (self->priv->native_kernels == NULL)
+    return NULL;
+
+  native = g_hash_table_lookup (self->priv->native_kernels, kernel_name);
+  if (native == NULL)
+    return NULL;
+
+  *user_data = native->user_data;
+
+  return native->func;
+}
+
 /**
  * gocl_program_get_context:
  * @self: The #GoclProgram
  *
  * Obtain the #GoclContext the program belongs to.
  *
- * Returns: (transfer none): A #GoclContext. The returned object is owned by
- *   the program, do not free.
+ * Returns: (transfer none): A #GoclContext, or %NULL for programs created
+ *   with gocl_program_new_native(). The returned object is owned by the
+ *   program, do not free.
  **/
 GoclContext *
 gocl_program_get_context (GoclProgram *self)
@@ -354,6 +484,53 @@ gocl_program_get_kernel (GoclProgram *self, const gchar *kernel_name)
                                       NULL));
 }
 
+/**
+ * gocl_program_add_native_kernel:
+ * @self: The #GoclProgram
+ * @kernel_name: The name of the kernel
+ * @func: (scope notified): The native implementation of the kernel
+ * @user_data: (allow-none): Arbitrary data to pass to @func, or %NULL
+ * @notify: (allow-none): A function to free @user_data, or %NULL
+ *
+ * Registers a native C implementation for the kernel named @kernel_name,
+ * replacing any previous one. Native implementations are only used by
+ * programs created with gocl_program_new_native(), and registering them on
+ * any other program has no effect. Applications that want a fallback create
+ * the program with gocl_program_new() when an OpenCL context is available,
+ * and only otherwise create it with gocl_program_new_native() and register
+ * the native implementations of its kernels on it.
+ *
+ * Kernels obtained before the registration are not affected.
+ **/
+void
+gocl_program_add_native_kernel (GoclProgram          *self,
+                                const gchar          *kernel_name,
+                                GoclNativeKernelFunc  func,
+                                gpointer              user_data,
+                                GDestroyNotify        notify)
+{
+  NativeKernel *native;
+
+  g_return_if_fail (GOCL_IS_PROGRAM (self));
+  g_return_if_fail (kernel_name != NULL);
+  g_return_if_fail (func != NULL);
+
+  if (self->priv->native_kernels == NULL)
+    self->priv->native_kernels = g_hash_table_new_full (g_str_hash,
+                                                        g_str_equal,
+                                                        g_free,
+                                                        free_native_kernel);
+
+  native = g_slice_new (NativeKernel);
+  native->func = func;
+  native->user_data = user_data;
+  native->notify = notify;
+
+  g_hash_table_replace (self->priv->native_kernels,
+                        g_strdup (kernel_name),
+                        native);
+}
+
 /**
  * gocl_program_build_sync:
  * @self: The #GoclProgram
@@ -367,21 +544,38 @@ gocl_program_get_kernel (GoclProgram *self, const gchar *kernel_name)
  * documentation website:
  * http://www.khronos.org/registry/cl/sdk/1.0/docs/man/xhtml/clBuildProgram.html
  *
+ * The "-cl-kernel-arg-info" option is always added to @options, so that the
+ * arguments of the kernels in the program can be inspected and set by name
+ * (see gocl_kernel_set_argument_by_name()).
+ *
  * Returns: %TRUE on success or %FALSE on error
  **/
 gboolean
 gocl_program_build_sync (GoclProgram *self, const gchar *options)
 {
   cl_int err_code;
+  gchar *full_options;
 
   g_return_val_if_fail (GOCL_IS_PROGRAM (self), FALSE);
 
+  /* native programs have nothing to build */
+  if (self->priv->program == NULL)
+    return TRUE;
+
+  if (options == NULL || options[0] == '\0')
+    full_options = g_strdup (KERNEL_ARG_INFO_OPTION);
+  else if (strstr (options, KERNEL_ARG_INFO_OPTION) != NULL)
+    full_options = g_strdup (options);
+  else
+    full_options = g_strconcat (options, " ", KERNEL_ARG_INFO_OPTION, NULL);
+
   err_code = clBuildProgram (self->priv->program,
                              0,
                              NULL,
-                             options,
+                             full_options,
                              NULL,
                              NULL);
+  g_free (full_options);
 
   return ! gocl_error_check_opencl_internal (err_code);
 }
@@ -61,12 +61,19 @@ GoclProgram *          gocl_program_new                        (GoclContext  *co
                                                                 guint         num_sources);
 GoclProgram *          gocl_program_new_from_file_sync         (GoclContext *context,
                                                                 const gchar *filename);
+GoclProgram *          gocl_program_new_native                 (void);
 
 GoclContext *          gocl_program_get_context                (GoclProgram *self);
 
 GoclKernel *           gocl_program_get_kernel                 (GoclProgram *self,
                                                                 const gchar *kernel_name);
 
+void                   gocl_program_add_native_kernel          (GoclProgram          *self,
+                                                                const gchar          *kernel_name,
+                                                                GoclNativeKernelFunc  func,
+                                                                gpointer              user_data,
+                                                                GDestroyNotify        notify);
+
 gboolean               gocl_program_build_sync                 (GoclProgram *self,
                                                                 const gchar *options);
 void                   gocl_program_build                      (GoclProgram         *self,
@@ -33,6 +33,39 @@
  * elsewhere, like gocl_kernel_run_in_device(), which internally enqueues
  * the execution; or gocl_buffer_read_sync() and gocl_buffer_write_sync(), which
  * internally enqueues read/write operations on the command queue.
+ *
+ * Commands that are enqueued without an event, like
+ * gocl_kernel_run_in_device_detached(), can be synchronized with by calling
+ * gocl_queue_enqueue_marker(), which returns a #GoclEvent that triggers once
+ * all previously enqueued commands complete. gocl_queue_enqueue_barrier()
+ * does the same, and additionally holds back the commands enqueued after it.
+ * Both events work with gocl_event_then() and gocl_event_wait() like any
+ * other, so applications can synchronize once per group of commands instead
+ * of keeping an event for every command.
+ *
+ * Commands in a queue created with %GOCL_QUEUE_FLAGS_OUT_OF_ORDER may execute
+ * in any order. To keep such queues usable, Gocl tracks the last command that
+ * wrote to each #GoclBuffer and the commands that are still reading from it,
+ * and makes new commands wait for them as needed (read-after-write,
+ * write-after-read and write-after-write hazards). This covers the transfer
+ * methods of #GoclBuffer and kernel executions, for buffers bound with
+ * gocl_kernel_set_argument_buffer(). Buffers created with
+ * %GOCL_BUFFER_FLAGS_READ_ONLY are considered read by kernels; any other
+ * buffer is considered written. Tracking is per queue: commands in different
+ * queues still have to be synchronized with explicit event wait lists.
+ *
+ * Submission of commands to the device can be amortized by grouping them in
+ * batches with gocl_queue_begin_batch() and gocl_queue_end_batch(), and by
+ * setting an auto-flush policy with gocl_queue_set_auto_flush(). The policy
+ * flushes the queue after a number of commands, after a number of bytes
+ * transferred, when the oldest unflushed command has waited for a given time,
+ * or when the main loop becomes idle. Inside a batch, only the byte and time
+ * limits apply, and the queue is flushed when the outermost batch ends.
+ *
+ * Each #GoclQueue keeps a small pool of released #GoclEvent objects, which
+ * are recycled by the next operations enqueued on it. This avoids
+ * constructing and finalizing an event object for every command when
+ * issuing many small commands.
  **/
 
 /**
@@ -57,8 +90,41 @@ struct _GoclQueuePrivate
   GoclDevice *device;
 
   guint flags;
+
+  gint pending_commands;
+
+  gboolean track_hazards;
+  GMutex hazards_mutex;
+  GHashTable *hazards;
+
+  GMutex event_pool_mutex;
+  GQueue event_pool;
+  gboolean event_pool_closed;
+
+  gint flush_accounting;
+  GMutex flush_mutex;
+  guint batch_depth;
+  guint flush_max_commands;
+  gsize flush_max_bytes;
+  guint flush_max_latency;
+  gboolean flush_on_idle;
+  GMainContext *flush_context;
+  guint unflushed_commands;
+  gsize unflushed_bytes;
+  GSource *latency_source;
+  GSource *idle_source;
 };
 
+/* maximum number of released events kept for reuse by each queue */
+#define EVENT_POOL_MAX_SIZE 64
+
+/* commands that must complete before a buffer can be accessed again */
+typedef struct
+{
+  cl_event writer;
+  GPtrArray *readers;
+} Hazard;
+
 /* properties */
 enum
 {
@@ -85,6 +151,11 @@ static void           get_property                     (GObject    *obj,
                                                         GValue     *value,
                                                         GParamSpec *pspec);
 
+static void           free_hazard                      (gpointer data);
+static gboolean       flush_pending                    (GoclQueue *self);
+static void           on_buffer_finalized              (gpointer  data,
+                                                        GObject  *buffer);
+
 G_DEFINE_TYPE_WITH_CODE (GoclQueue, gocl_queue, G_TYPE_OBJECT,
                          G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE,
                                                 gocl_queue_initable_iface_init));
@@ -151,8 +222,11 @@ gocl_queue_initable_init (GInitable     *initable,
 
   if (gocl_error_check_opencl (err_code, error))
     return FALSE;
-  else
-    return TRUE;
+
+  self->priv->track_hazards =
+    (self->priv->flags & GOCL_QUEUE_FLAGS_OUT_OF_ORDER) != 0;
+
+  return TRUE;
 }
 
 static void
@@ -163,19 +237,66 @@ gocl_queue_init (GoclQueue *self)
   self->priv = priv = GOCL_QUEUE_GET_PRIVATE (self);
 
   priv->queue = NULL;
+
+  priv->pending_commands = 0;
+
+  priv->track_hazards = FALSE;
+  g_mutex_init (&priv->hazards_mutex);
+  priv->hazards = g_hash_table_new_full (g_direct_hash,
+                                         g_direct_equal,
+                                         NULL,
+                                         free_hazard);
+
+  g_mutex_init (&priv->event_pool_mutex);
+  g_queue_init (&priv->event_pool);
+  priv->event_pool_closed = FALSE;
+
+  priv->flush_accounting = FALSE;
+  g_mutex_init (&priv->flush_mutex);
+  priv->batch_depth = 0;
+  priv->flush_max_commands = 0;
+  priv->flush_max_bytes = 0;
+  priv->flush_max_latency = 0;
+  priv->flush_on_idle = FALSE;
+  priv->flush_context = NULL;
+  priv->unflushed_commands = 0;
+  priv->unflushed_bytes = 0;
+  priv->latency_source = NULL;
+  priv->idle_source = NULL;
 }
 
 static void
 gocl_queue_dispose (GObject *obj)
 {
   GoclQueue *self = GOCL_QUEUE (obj);
+  GoclEvent *event;
 
   /* ensure that no commands are lost when the queue is disposed */
-  if (!gocl_queue_flush (self))
+  if (! flush_pending (self))
     {
       g_warning ("Could not flush the queue successfully.");
     }
 
+  g_mutex_lock (&self->priv->event_pool_mutex);
+  self->priv->event_pool_closed = TRUE;
+  g_mutex_unlock (&self->priv->event_pool_mutex);
+
+  while ((event = g_queue_pop_head (&self->priv->event_pool)) != NULL)
+    g_object_unref (event);
+
+  if (self->priv->hazards != NULL)
+    {
+      GHashTableIter iter;
+      gpointer buffer;
+
+      g_hash_table_iter_init (&iter, self->priv->hazards);
+      while (g_hash_table_iter_next (&iter, &buffer, NULL))
+        g_object_weak_unref (G_OBJECT (buffer), on_buffer_finalized, self);
+
+      g_hash_table_unref (self->priv->hazards);
+      self->priv->hazards = NULL;
+    }
+
   if (self->priv->device != NULL)
     {
       g_object_unref (self->priv->device);
@@ -193,6 +314,13 @@ gocl_queue_finalize (GObject *obj)
   if (self->priv->queue != NULL)
     clReleaseCommandQueue (self->priv->queue);
 
+  g_mutex_clear (&self->priv->event_pool_mutex);
+  g_mutex_clear (&self->priv->hazards_mutex);
+  g_mutex_clear (&self->priv->flush_mutex);
+
+  if (self->priv->flush_context != NULL)
+    g_main_context_unref (self->priv->flush_context);
+
   G_OBJECT_CLASS (gocl_queue_parent_class)->finalize (obj);
 }
 
@@ -248,6 +376,381 @@ get_property (GObject    *obj,
     }
 }
 
+static void
+release_event (gpointer data)
+{
+  clReleaseEvent (data);
+}
+
+static void
+free_hazard (gpointer data)
+{
+  Hazard *hazard = data;
+
+  if (hazard->writer != NULL)
+    clReleaseEvent (hazard->writer);
+
+  g_ptr_array_unref (hazard->readers);
+
+  g_slice_free (Hazard, hazard);
+}
+
+static void
+on_buffer_finalized (gpointer data, GObject *buffer)
+{
+  GoclQueue *self = GOCL_QUEUE (data);
+
+  g_mutex_lock (&self->priv->hazards_mutex);
+  g_hash_table_remove (self->priv->hazards, buffer);
+  g_mutex_unlock (&self->priv->hazards_mutex);
+}
+
+static gboolean
+event_is_pending (cl_event event)
+{
+  cl_int status;
+  cl_int err_code;
+
+  err_code = clGetEventInfo (event,
+                             CL_EVENT_COMMAND_EXECUTION_STATUS,
+                             sizeof (cl_int),
+                             &status,
+                             NULL);
+
+  return err_code == CL_SUCCESS && status > CL_COMPLETE;
+}
+
+static void
+prune_readers (Hazard *hazard)
+{
+  guint i = 0;
+
+  while (i < hazard->readers->len)
+    {
+      if (event_is_pending (g_ptr_array_index (hazard->readers, i)))
+        i++;
+      else
+        g_ptr_array_remove_index_fast (hazard->readers, i);
+    }
+}
+
+static void
+collect_hazards (GoclQueue              *self,
+                 const GoclBufferAccess *accesses,
+                 guint                   n_accesses,
+                 GPtrArray              *wait_list)
+{
+  guint i;
+  guint j;
+
+  for (i = 0; i < n_accesses; i++)
+    {
+      Hazard *hazard;
+
+      hazard = g_hash_table_lookup (self->priv->hazards, accesses[i].buffer);
+      if (hazard == NULL)
+        continue;
+
+      /* read-after-write and write-after-write */
+      if (hazard->writer != NULL)
+        {
+          if (event_is_pending (hazard->writer))
+            {
+              g_ptr_array_add (wait_list, hazard->writer);
+            }
+          else
+            {
+              clReleaseEvent (hazard->writer);
+              hazard->writer = NULL;
+            }
+        }
+
+      /* write-after-read */
+      if (accesses[i].write)
+        {
+          prune_readers (hazard);
+
+          for (j = 0; j < hazard->readers->len; j++)
+            g_ptr_array_add (wait_list, g_ptr_array_index (hazard->readers, j));
+        }
+    }
+}
+
+static void
+record_accesses (GoclQueue              *self,
+                 const GoclBufferAccess *accesses,
+                 guint                   n_accesses,
+                 cl_event                event)
+{
+  guint pass;
+  guint i;
+
+  /* reads are recorded before writes, so that a command that both reads and
+     writes a buffer ends up as its last writer */
+  for (pass = 0; pass < 2; pass++)
+    for (i = 0; i < n_accesses; i++)
+      {
+        Hazard *hazard;
+
+        if (accesses[i].write != (pass == 1))
+          continue;
+
+        hazard = g_hash_table_lookup (self->priv->hazards, accesses[i].buffer);
+        if (hazard == NULL)
+          {
+            hazard = g_slice_new0 (Hazard);
+            hazard->readers = g_ptr_array_new_with_free_func (release_event);
+
+            g_hash_table_insert (self->priv->hazards,
+                                 accesses[i].buffer,
+                                 hazard);
+            g_object_weak_ref (G_OBJECT (accesses[i].buffer),
+                               on_buffer_finalized,
+                               self);
+          }
+
+        clRetainEvent (event);
+
+        if (accesses[i].write)
+          {
+            if (hazard->writer != NULL)
+              clReleaseEvent (hazard->writer);
+            hazard->writer = event;
+
+            g_ptr_array_set_size (hazard->readers, 0);
+          }
+        else
+          {
+            prune_readers (hazard);
+            g_ptr_array_add (hazard->readers, event);
+          }
+      }
+}
+
+static gsize
+get_transfer_size (const GoclBufferAccess *accesses, guint n_accesses)
+{
+  gsize size = 0;
+  guint i;
+
+  for (i = 0; i < n_accesses; i++)
+    size += accesses[i].transfer_size;
+
+  return size;
+}
+
+static void
+destroy_source (GSource *source)
+{
+  if (source == NULL)
+    return;
+
+  g_source_destroy (source);
+  g_source_unref (source);
+}
+
+/* must be called with flush_mutex held; the stolen sources are destroyed
+   by the caller after releasing it, since destroying them may drop the
+   last reference to the queue */
+static void
+reset_unflushed (GoclQueue *self, GSource **latency_source, GSource **idle_source)
+{
+  self->priv->unflushed_commands = 0;
+  self->priv->unflushed_bytes = 0;
+
+  *latency_source = self->priv->latency_source;
+  self->priv->latency_source = NULL;
+
+  *idle_source = self->priv->idle_source;
+  self->priv->idle_source = NULL;
+}
+
+static gboolean
+flush_pending (GoclQueue *self)
+{
+  GSource *latency_source;
+  GSource *idle_source;
+  cl_int err_code;
+
+  g_mutex_lock (&self->priv->flush_mutex);
+  reset_unflushed (self, &latency_source, &idle_source);
+  g_mutex_unlock (&self->priv->flush_mutex);
+
+  destroy_source (latency_source);
+  destroy_source (idle_source);
+
+  err_code = clFlush (self->priv->queue);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
+static gboolean
+on_flush_source (gpointer user_data)
+{
+  flush_pending (GOCL_QUEUE (user_data));
+
+  return FALSE;
+}
+
+static GSource *
+add_flush_source (GoclQueue *self, guint timeout)
+{
+  GSource *source;
+
+  if (timeout == 0)
+    {
+      source = g_idle_source_new ();
+      g_source_set_priority (source, G_PRIORITY_DEFAULT_IDLE);
+    }
+  else
+    {
+      source = g_timeout_source_new (timeout);
+    }
+
+  g_source_set_callback (source,
+                         on_flush_source,
+                         g_object_ref (self),
+                         g_object_unref);
+  g_source_attach (source, self->priv->flush_context);
+
+  return source;
+}
+
+/* accounts for commands just enqueued, and flushes the queue if the
+   auto-flush policy says so */
+static void
+commands_enqueued (GoclQueue *self, guint n_commands, gsize n_bytes)
+{
+  GoclQueuePrivate *priv = self->priv;
+  GSource *latency_source = NULL;
+  GSource *idle_source = NULL;
+  gboolean flush = FALSE;
+
+  if (! g_atomic_int_get (&priv->flush_accounting))
+    return;
+
+  g_mutex_lock (&priv->flush_mutex);
+
+  priv->unflushed_commands += n_commands;
+  priv->unflushed_bytes += n_bytes;
+
+  if (priv->flush_max_bytes > 0 &&
+      priv->unflushed_bytes >= priv->flush_max_bytes)
+    {
+      flush = TRUE;
+    }
+  else if (priv->batch_depth == 0 &&
+           priv->flush_max_commands > 0 &&
+           priv->unflushed_commands >= priv->flush_max_commands)
+    {
+      flush = TRUE;
+    }
+
+  if (flush)
+    {
+      reset_unflushed (self, &latency_source, &idle_source);
+    }
+  else if (priv->unflushed_commands > 0)
+    {
+      if (priv->flush_max_latency > 0 && priv->latency_source == NULL)
+        priv->latency_source = add_flush_source (self, priv->flush_max_latency);
+
+      if (priv->flush_on_idle &&
+          priv->batch_depth == 0 &&
+          priv->idle_source == NULL)
+        {
+          priv->idle_source = add_flush_source (self, 0);
+        }
+    }
+
+  g_mutex_unlock (&priv->flush_mutex);
+
+  if (flush)
+    {
+      destroy_source (latency_source);
+      destroy_source (idle_source);
+
+      gocl_error_check_opencl_internal (clFlush (priv->queue));
+    }
+}
+
+static GoclEvent *
+enqueue_sync_point (GoclQueue *self, gboolean barrier, GList *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  cl_event *_event_wait_list;
+  guint event_wait_list_len;
+  GoclEvent *_event;
+
+  _event_wait_list = gocl_event_list_to_array (event_wait_list,
+                                               &event_wait_list_len);
+
+  if (barrier)
+    {
+      /* hold the hazards lock, so that no tracked command is enqueued
+         between the barrier and the reset of the hazards */
+      g_mutex_lock (&self->priv->hazards_mutex);
+
+      err_code = clEnqueueBarrierWithWaitList (self->priv->queue,
+                                               event_wait_list_len,
+                                               _event_wait_list,
+                                               &event);
+
+      if (err_code == CL_SUCCESS &&
+          event_wait_list_len == 0 &&
+          self->priv->hazards != NULL)
+        {
+          GHashTableIter iter;
+          gpointer buffer;
+
+          g_hash_table_iter_init (&iter, self->priv->hazards);
+          while (g_hash_table_iter_next (&iter, &buffer, NULL))
+            {
+              g_object_weak_unref (G_OBJECT (buffer),
+                                   on_buffer_finalized,
+                                   self);
+              g_hash_table_iter_remove (&iter);
+            }
+        }
+
+      g_mutex_unlock (&self->priv->hazards_mutex);
+    }
+  else
+    {
+      err_code = clEnqueueMarkerWithWaitList (self->priv->queue,
+                                              event_wait_list_len,
+                                              _event_wait_list,
+                                              &event);
+    }
+
+  g_free (_event_wait_list);
+
+  if (err_code == CL_SUCCESS)
+    commands_enqueued (self, 1, 0);
+
+  _event = gocl_event_new_from_enqueue (self, err_code, event);
+  if (err_code == CL_SUCCESS)
+    gocl_event_set_event_wait_list (_event, event_wait_list);
+
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
+
+static void
+update_flush_accounting (GoclQueue *self)
+{
+  GoclQueuePrivate *priv = self->priv;
+
+  g_atomic_int_set (&priv->flush_accounting,
+                    priv->batch_depth > 0 ||
+                    priv->flush_max_commands > 0 ||
+                    priv->flush_max_bytes > 0 ||
+                    priv->flush_max_latency > 0 ||
+                    priv->flush_on_idle);
+}
+
 /* public */
 
 /**
@@ -268,6 +771,219 @@ gocl_queue_get_queue (GoclQueue *self)
   return self->priv->queue;
 }
 
+/**
+ * gocl_queue_take_pooled_event: (skip)
+ * @self: The #GoclQueue
+ *
+ * Takes a recycled #GoclEvent from the event pool of this queue, if any.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: (transfer full): A reset #GoclEvent, or %NULL if the pool is empty
+ **/
+GoclEvent *
+gocl_queue_take_pooled_event (GoclQueue *self)
+{
+  GoclEvent *event;
+
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), NULL);
+
+  g_mutex_lock (&self->priv->event_pool_mutex);
+  event = g_queue_pop_head (&self->priv->event_pool);
+  g_mutex_unlock (&self->priv->event_pool_mutex);
+
+  return event;
+}
+
+/**
+ * gocl_queue_recycle_event: (skip)
+ * @self: The #GoclQueue
+ * @event: A #GoclEvent that has been reset
+ *
+ * Adds @event to the event pool of this queue, taking a new reference on it.
+ * This is called from the dispose handler of #GoclEvent, and fails if the
+ * pool is full or the queue is being disposed.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: %TRUE if @event was added to the pool, %FALSE otherwise
+ **/
+gboolean
+gocl_queue_recycle_event (GoclQueue *self, GoclEvent *event)
+{
+  gboolean recycled = FALSE;
+
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), FALSE);
+
+  g_mutex_lock (&self->priv->event_pool_mutex);
+  if (! self->priv->event_pool_closed &&
+      g_queue_get_length (&self->priv->event_pool) < EVENT_POOL_MAX_SIZE)
+    {
+      g_queue_push_head (&self->priv->event_pool, g_object_ref (event));
+      recycled = TRUE;
+    }
+  g_mutex_unlock (&self->priv->event_pool_mutex);
+
+  return recycled;
+}
+
+/**
+ * gocl_queue_enqueue: (skip)
+ * @self: The #GoclQueue
+ * @accesses: (array length=n_accesses) (allow-none): The buffers accessed by
+ * the command, or %NULL
+ * @n_accesses: The length of @accesses
+ * @event_wait_list_len: The length of @event_wait_list
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): The
+ * #cl_event's the command should wait for, or %NULL
+ * @out_event: (out) (allow-none): Location for the #cl_event of the command,
+ * or %NULL
+ * @enqueue_func: The function that actually enqueues the command
+ * @user_data: Arbitrary data passed to @enqueue_func
+ *
+ * Enqueues a command in this queue by calling @enqueue_func. If the queue is
+ * out-of-order, the events of previous commands that conflict with
+ * @accesses are added to the wait list, and the command is recorded as the
+ * new reader or writer of the buffers. The command is then accounted for by
+ * the auto-flush policy of the queue.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: The error code returned by @enqueue_func
+ **/
+cl_int
+gocl_queue_enqueue (GoclQueue              *self,
+                    const GoclBufferAccess *accesses,
+                    guint                   n_accesses,
+                    guint                   event_wait_list_len,
+                    const cl_event         *event_wait_list,
+                    cl_event               *out_event,
+                    GoclEventEnqueueFunc    enqueue_func,
+                    gpointer                user_data)
+{
+  GPtrArray *wait_list;
+  cl_event event = NULL;
+  cl_int err_code;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), CL_INVALID_COMMAND_QUEUE);
+
+  if (! self->priv->track_hazards || n_accesses == 0)
+    {
+      err_code = enqueue_func (self->priv->queue,
+                               event_wait_list_len,
+                               event_wait_list,
+                               out_event,
+                               user_data);
+      if (err_code == CL_SUCCESS)
+        commands_enqueued (self, 1, get_transfer_size (accesses, n_accesses));
+
+      return err_code;
+    }
+
+  wait_list = g_ptr_array_sized_new (event_wait_list_len + n_accesses);
+  for (i = 0; i < event_wait_list_len; i++)
+    g_ptr_array_add (wait_list, event_wait_list[i]);
+
+  /* the lock is held while enqueuing, so that concurrent commands are
+     recorded in the same order they are enqueued */
+  g_mutex_lock (&self->priv->hazards_mutex);
+
+  collect_hazards (self, accesses, n_accesses, wait_list);
+
+  err_code = enqueue_func (self->priv->queue,
+                           wait_list->len,
+                           wait_list->len > 0 ?
+                             (const cl_event *) wait_list->pdata : NULL,
+                           &event,
+                           user_data);
+
+  if (err_code == CL_SUCCESS)
+    record_accesses (self, accesses, n_accesses, event);
+
+  g_mutex_unlock (&self->priv->hazards_mutex);
+
+  g_ptr_array_unref (wait_list);
+
+  if (err_code == CL_SUCCESS)
+    {
+      if (out_event != NULL)
+        *out_event = event;
+      else
+        clReleaseEvent (event);
+
+      commands_enqueued (self, 1, get_transfer_size (accesses, n_accesses));
+    }
+
+  return err_code;
+}
+
+/**
+ * gocl_queue_add_pending_commands: (skip)
+ * @self: The #GoclQueue
+ * @delta: The number of commands to add, or a negative value to subtract
+ *
+ * Updates the count of commands enqueued in this queue that have not yet
+ * completed. Only commands tracked by a #GoclEvent are counted.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ **/
+void
+gocl_queue_add_pending_commands (GoclQueue *self, gint delta)
+{
+  g_return_if_fail (GOCL_IS_QUEUE (self));
+
+  g_atomic_int_add (&self->priv->pending_commands, delta);
+}
+
+/**
+ * gocl_queue_get_pending_commands: (skip)
+ * @self: The #GoclQueue
+ *
+ * Retrieves the count of commands enqueued in this queue that have not yet
+ * completed, as updated by gocl_queue_add_pending_commands().
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: The number of pending commands
+ **/
+guint
+gocl_queue_get_pending_commands (GoclQueue *self)
+{
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), 0);
+
+  return MAX (g_atomic_int_get (&self->priv->pending_commands), 0);
+}
+
+/**
+ * gocl_queue_flush_early: (skip)
+ * @self: The #GoclQueue
+ *
+ * Flushes the queue so that the device starts executing the commands enqueued
+ * so far, while more are being enqueued, unless a batch is in progress (see
+ * gocl_queue_begin_batch()), in which case the batch decides when to flush.
+ *
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_queue_flush_early (GoclQueue *self)
+{
+  gboolean batched;
+
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), FALSE);
+
+  g_mutex_lock (&self->priv->flush_mutex);
+  batched = self->priv->batch_depth > 0;
+  g_mutex_unlock (&self->priv->flush_mutex);
+
+  if (batched)
+    return TRUE;
+
+  return flush_pending (self);
+}
+
 /**
  * gocl_queue_get_device:
  * @self: The #GoclQueue
@@ -313,13 +1029,9 @@ gocl_queue_get_flags (GoclQueue *self)
 gboolean
 gocl_queue_flush (GoclQueue *self)
 {
-  gint ret;
-
   g_return_val_if_fail (GOCL_IS_QUEUE (self), FALSE);
 
-  ret = clFlush (self->priv->queue);
-
-  return ! gocl_error_check_opencl_internal (ret);
+  return flush_pending (self);
 };
 
 /**
@@ -334,10 +1046,218 @@ gboolean
 gocl_queue_finish (GoclQueue *self)
 {
   gint ret;
+  GSource *latency_source;
+  GSource *idle_source;
 
   g_return_val_if_fail (GOCL_IS_QUEUE (self), FALSE);
 
+  g_mutex_lock (&self->priv->flush_mutex);
+  reset_unflushed (self, &latency_source, &idle_source);
+  g_mutex_unlock (&self->priv->flush_mutex);
+
+  destroy_source (latency_source);
+  destroy_source (idle_source);
+
   ret = clFinish (self->priv->queue);
 
   return ! gocl_error_check_opencl_internal (ret);
 };
+
+/**
+ * gocl_queue_enqueue_marker:
+ * @self: The #GoclQueue
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Enqueues a marker command, which completes when all the events in
+ * @event_wait_list have triggered or, if @event_wait_list is %NULL, when all
+ * the commands previously enqueued in this queue have completed. The marker
+ * does not block the execution of later commands.
+ *
+ * This provides a cheap synchronization point for commands enqueued without
+ * an event, like gocl_buffer_write_detached() or
+ * gocl_kernel_run_in_device_detached().
+ *
+ * Returns: (transfer none): A #GoclEvent that triggers when the marker
+ * completes
+ **/
+GoclEvent *
+gocl_queue_enqueue_marker (GoclQueue *self, GList *event_wait_list)
+{
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), NULL);
+
+  return enqueue_sync_point (self, FALSE, event_wait_list);
+}
+
+/**
+ * gocl_queue_enqueue_barrier:
+ * @self: The #GoclQueue
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Enqueues a barrier command. Like a marker (see
+ * gocl_queue_enqueue_marker()), the barrier completes when all the events in
+ * @event_wait_list have triggered or, if @event_wait_list is %NULL, when all
+ * the commands previously enqueued in this queue have completed. Unlike a
+ * marker, commands enqueued after the barrier do not start until it
+ * completes, even in out-of-order queues.
+ *
+ * In out-of-order queues, a barrier without a wait list also discards the
+ * buffer hazards tracked so far, since every later command is already
+ * ordered after all the previous ones.
+ *
+ * Returns: (transfer none): A #GoclEvent that triggers when the barrier
+ * completes
+ **/
+GoclEvent *
+gocl_queue_enqueue_barrier (GoclQueue *self, GList *event_wait_list)
+{
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), NULL);
+
+  return enqueue_sync_point (self, TRUE, event_wait_list);
+}
+
+/**
+ * gocl_queue_set_auto_flush:
+ * @self: The #GoclQueue
+ * @max_commands: The number of unflushed commands that triggers a flush, or
+ * 0 to disable
+ * @max_bytes: The number of unflushed bytes transferred between host and
+ * device that triggers a flush, or 0 to disable
+ * @max_latency: The maximum time in milliseconds an enqueued command waits
+ * before the queue is flushed, or 0 to disable
+ * @flush_on_idle: Whether to flush the queue when the main loop becomes idle
+ *
+ * Sets the policy used to flush this queue automatically. By default all
+ * limits are disabled, and commands are submitted to the device only when
+ * the OpenCL implementation decides to, or when gocl_queue_flush() or
+ * gocl_queue_finish() are called.
+ *
+ * Inside a batch (see gocl_queue_begin_batch()), @max_commands and
+ * @flush_on_idle are ignored.
+ *
+ * The @max_latency and @flush_on_idle limits use sources attached to the
+ * thread-default main context of the caller, or to an internal context if
+ * headless mode is enabled (see gocl_event_set_headless_mode()).
+ **/
+void
+gocl_queue_set_auto_flush (GoclQueue *self,
+                           guint      max_commands,
+                           gsize      max_bytes,
+                           guint      max_latency,
+                           gboolean   flush_on_idle)
+{
+  GoclQueuePrivate *priv;
+  GMainContext *context;
+  GSource *latency_source = NULL;
+  GSource *idle_source = NULL;
+
+  g_return_if_fail (GOCL_IS_QUEUE (self));
+
+  priv = self->priv;
+
+  context = gocl_event_get_main_context ();
+  if (context != NULL)
+    g_main_context_ref (context);
+
+  g_mutex_lock (&priv->flush_mutex);
+
+  priv->flush_max_commands = max_commands;
+  priv->flush_max_bytes = max_bytes;
+  priv->flush_max_latency = max_latency;
+  priv->flush_on_idle = flush_on_idle;
+
+  if (priv->flush_context != NULL)
+    g_main_context_unref (priv->flush_context);
+  priv->flush_context = context;
+
+  /* pending sources follow the previous policy */
+  latency_source = priv->latency_source;
+  priv->latency_source = NULL;
+  idle_source = priv->idle_source;
+  priv->idle_source = NULL;
+
+  update_flush_accounting (self);
+
+  g_mutex_unlock (&priv->flush_mutex);
+
+  destroy_source (latency_source);
+  destroy_source (idle_source);
+
+  /* commands already waiting are accounted for under the new policy */
+  commands_enqueued (self, 0, 0);
+}
+
+/**
+ * gocl_queue_begin_batch:
+ * @self: The #GoclQueue
+ *
+ * Starts a batch of commands. Until the matching call to
+ * gocl_queue_end_batch(), the queue is not flushed because of the
+ * command count or main loop idle limits of the auto-flush policy, so that
+ * the commands are submitted to the device together. The byte and latency
+ * limits still apply, to keep the latency of the batch bounded.
+ *
+ * Batches can be nested; only the outermost one flushes the queue when it
+ * ends.
+ **/
+void
+gocl_queue_begin_batch (GoclQueue *self)
+{
+  GSource *idle_source;
+
+  g_return_if_fail (GOCL_IS_QUEUE (self));
+
+  g_mutex_lock (&self->priv->flush_mutex);
+
+  self->priv->batch_depth++;
+
+  idle_source = self->priv->idle_source;
+  self->priv->idle_source = NULL;
+
+  update_flush_accounting (self);
+
+  g_mutex_unlock (&self->priv->flush_mutex);
+
+  destroy_source (idle_source);
+}
+
+/**
+ * gocl_queue_end_batch:
+ * @self: The #GoclQueue
+ *
+ * Ends a batch of commands started with gocl_queue_begin_batch(). When the
+ * outermost batch ends, the commands enqueued since the last flush are
+ * submitted to the device.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_queue_end_batch (GoclQueue *self)
+{
+  gboolean flush;
+
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), FALSE);
+
+  g_mutex_lock (&self->priv->flush_mutex);
+
+  if (self->priv->batch_depth == 0)
+    {
+      g_mutex_unlock (&self->priv->flush_mutex);
+      g_warning ("gocl_queue_end_batch() called without a matching "
+                 "gocl_queue_begin_batch()");
+      return FALSE;
+    }
+
+  self->priv->batch_depth--;
+  flush = self->priv->batch_depth == 0 && self->priv->unflushed_commands > 0;
+
+  update_flush_accounting (self);
+
+  g_mutex_unlock (&self->priv->flush_mutex);
+
+  if (flush)
+    return flush_pending (self);
+
+  return TRUE;
+}
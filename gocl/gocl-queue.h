@@ -58,6 +58,15 @@ gboolean               gocl_queue_flush                      (GoclQueue *self);
 
 gboolean               gocl_queue_finish                     (GoclQueue *self);
 
+void                   gocl_queue_set_auto_flush             (GoclQueue *self,
+                                                              guint      max_commands,
+                                                              gsize      max_bytes,
+                                                              guint      max_latency,
+                                                              gboolean   flush_on_idle);
+
+void                   gocl_queue_begin_batch                (GoclQueue *self);
+gboolean               gocl_queue_end_batch                  (GoclQueue *self);
+
 G_END_DECLS
 
 #endif /* __GOCL_QUEUE_H__ */
@@ -31,6 +31,7 @@
 #include "gocl-kernel.h"
 #include "gocl-queue.h"
 #include "gocl-image.h"
+#include "gocl-command-graph.h"
 
 G_BEGIN_DECLS
 